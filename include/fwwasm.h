@@ -7,7 +7,12 @@ Functions that are exposed from the WASM engine for use in Free-Wili WASM script
 
 // SPARTAHACKs release 2-1-2026
 
+#if defined(__wasm__)
 #define WASM_IMPORT(NAME) __attribute__((import_module("wiliwasm"))) __attribute__((import_name(NAME)))
+#else
+// host builds (tools and stand-ins) see the imports as ordinary C functions
+#define WASM_IMPORT(NAME)
+#endif
 #define WASM_EXPORT extern "C" __attribute__((used)) __attribute__((visibility("default")))
 #define WASM_EXPORT_AS(NAME) WASM_EXPORT __attribute__((export_name(NAME)))
 
@@ -0,0 +1,283 @@
+/**
+@file
+	@brief Free-Wili wasm accelerometer processing
+Batch pipeline for the X/Y/Z stream enabled with setSensorSettings(): samples are collected in a structure-of-arrays
+AccelBatch and AccelFusion runs calibration, a low-pass filter that separates gravity from motion, tilt and vibration
+RMS over the whole batch at once. The calibration and RMS kernels use WASM SIMD128 when the module is built with
+-msimd128, four samples per instruction; the low-pass filter is a recurrence and runs the three channels interleaved.
+
+The Free-Wili has no gyroscope, so the complementary split is between the low-passed gravity estimate (used for
+pitch and roll) and its complement, the dynamic acceleration (used for vibration).
+
+@code
+static fwwasm::AccelBatch<32> batch;
+static fwwasm::AccelFusion<32> fusion(2.0f, 10); // 2 Hz gravity cutoff, setSensorSettings(..., 10, ...)
+// for each FWGUI_EVENT_GUI_SENSOR_DATA event
+if (batch.push(x, y, z))
+{
+	fusion.process(batch);
+	fwwasm::print("pitch {:.1f} roll {:.1f} vib {:.3f}\n", fusion.pitch(), fusion.roll(), fusion.vibrationRms());
+	batch.clear();
+}
+@endcode
+*/
+#pragma once
+
+#include "fwwasm.h"
+#include "fwwasm_format.h"
+
+#include <stddef.h>
+#include <math.h>
+
+#if defined(__wasm_simd128__)
+#include <wasm_simd128.h>
+#endif
+
+namespace fwwasm
+{
+
+/**
+ * @brief accelerometer samples in structure-of-arrays layout
+ * @tparam N the batch capacity
+ */
+template <size_t N>
+struct AccelBatch
+{
+	float x[N];
+	float y[N];
+	float z[N];
+	size_t count;
+
+	AccelBatch() : count(0) {}
+
+	/**
+	 * @brief add one sample
+	 * @return true when the batch is full
+	 */
+	bool push(float sx, float sy, float sz)
+	{
+		if (count < N)
+		{
+			x[count] = sx;
+			y[count] = sy;
+			z[count] = sz;
+			count++;
+		}
+		return count == N;
+	}
+
+	void clear() { count = 0; }
+};
+
+/**
+ * @brief calibration applied as out = matrix * (raw - bias)
+ *
+ * The matrix corrects scale, axis misalignment and mounting rotation; identity() leaves samples unchanged.
+ */
+struct AccelCalibration
+{
+	float bias[3];
+	float matrix[9]; ///< row major
+
+	static AccelCalibration identity()
+	{
+		AccelCalibration c = { { 0, 0, 0 }, { 1, 0, 0, 0, 1, 0, 0, 0, 1 } };
+		return c;
+	}
+};
+
+/**
+ * @brief apply a calibration to channel arrays in place
+ * @param x the X samples
+ * @param y the Y samples
+ * @param z the Z samples
+ * @param count the number of samples
+ * @param cal the calibration
+ */
+inline void accelCalibrate(float* x, float* y, float* z, size_t count, const AccelCalibration& cal)
+{
+	const float* m = cal.matrix;
+	size_t i = 0;
+#if defined(__wasm_simd128__)
+	v128_t bx = wasm_f32x4_splat(cal.bias[0]), by = wasm_f32x4_splat(cal.bias[1]), bz = wasm_f32x4_splat(cal.bias[2]);
+	v128_t mv[9];
+	for (int k = 0; k < 9; k++)
+		mv[k] = wasm_f32x4_splat(m[k]);
+	for (; i + 4 <= count; i += 4)
+	{
+		v128_t vx = wasm_f32x4_sub(wasm_v128_load(x + i), bx);
+		v128_t vy = wasm_f32x4_sub(wasm_v128_load(y + i), by);
+		v128_t vz = wasm_f32x4_sub(wasm_v128_load(z + i), bz);
+		for (int row = 0; row < 3; row++)
+		{
+			const v128_t* r = mv + row * 3;
+			v128_t out = wasm_f32x4_add(wasm_f32x4_add(wasm_f32x4_mul(r[0], vx), wasm_f32x4_mul(r[1], vy)), wasm_f32x4_mul(r[2], vz));
+			wasm_v128_store((row == 0 ? x : row == 1 ? y : z) + i, out);
+		}
+	}
+#endif
+	for (; i < count; i++)
+	{
+		float vx = x[i] - cal.bias[0];
+		float vy = y[i] - cal.bias[1];
+		float vz = z[i] - cal.bias[2];
+		x[i] = m[0] * vx + m[1] * vy + m[2] * vz;
+		y[i] = m[3] * vx + m[4] * vy + m[5] * vz;
+		z[i] = m[6] * vx + m[7] * vy + m[8] * vz;
+	}
+}
+
+/**
+ * @brief sum of squared differences between two sets of channel arrays
+ * @return the sum over all samples of |a - b|^2
+ */
+inline float accelSumSquares(const float* ax, const float* ay, const float* az, const float* bx, const float* by, const float* bz,
+	size_t count)
+{
+	size_t i = 0;
+	float sum = 0;
+#if defined(__wasm_simd128__)
+	v128_t acc = wasm_f32x4_splat(0);
+	for (; i + 4 <= count; i += 4)
+	{
+		v128_t dx = wasm_f32x4_sub(wasm_v128_load(ax + i), wasm_v128_load(bx + i));
+		v128_t dy = wasm_f32x4_sub(wasm_v128_load(ay + i), wasm_v128_load(by + i));
+		v128_t dz = wasm_f32x4_sub(wasm_v128_load(az + i), wasm_v128_load(bz + i));
+		acc = wasm_f32x4_add(acc, wasm_f32x4_add(wasm_f32x4_add(wasm_f32x4_mul(dx, dx), wasm_f32x4_mul(dy, dy)), wasm_f32x4_mul(dz, dz)));
+	}
+	sum = wasm_f32x4_extract_lane(acc, 0) + wasm_f32x4_extract_lane(acc, 1) + wasm_f32x4_extract_lane(acc, 2) +
+		wasm_f32x4_extract_lane(acc, 3);
+#endif
+	for (; i < count; i++)
+	{
+		float dx = ax[i] - bx[i];
+		float dy = ay[i] - by[i];
+		float dz = az[i] - bz[i];
+		sum += dx * dx + dy * dy + dz * dz;
+	}
+	return sum;
+}
+
+/**
+ * @brief calibration, gravity/motion split, tilt and vibration for batches of accelerometer samples.
+ * @tparam N the largest batch passed to process()
+ */
+template <size_t N>
+class AccelFusion
+{
+public:
+	/**
+	 * @brief create a pipeline
+	 * @param cutoffHz the gravity low-pass cutoff, motion below it is treated as orientation change
+	 * @param rateMs the sample interval, iRateMilliseconds of setSensorSettings()
+	 */
+	AccelFusion(float cutoffHz = 2.0f, int rateMs = 10)
+		: m_cal(AccelCalibration::identity()), m_alpha(1), m_primed(false), m_pitch(0), m_roll(0), m_rms(0), m_samples(0)
+	{
+		m_gravity[0] = m_gravity[1] = m_gravity[2] = 0;
+		setLowPass(cutoffHz, rateMs);
+	}
+
+	/// @brief replace the calibration
+	void setCalibration(const AccelCalibration& cal) { m_cal = cal; }
+
+	/**
+	 * @brief change the gravity low-pass filter
+	 * @param cutoffHz the cutoff frequency, 0 disables filtering
+	 * @param rateMs the sample interval
+	 */
+	void setLowPass(float cutoffHz, int rateMs)
+	{
+		if (cutoffHz <= 0 || rateMs <= 0)
+		{
+			m_alpha = 1;
+			return;
+		}
+		float dt = static_cast<float>(rateMs) / 1000.0f;
+		float rc = 1.0f / (2.0f * 3.14159265f * cutoffHz);
+		m_alpha = dt / (rc + dt);
+	}
+
+	/// @brief restart the filter from the next sample
+	void reset() { m_primed = false; }
+
+	/**
+	 * @brief run the pipeline over a batch; the batch is calibrated in place
+	 * @param batch the samples
+	 */
+	template <size_t M>
+	void process(AccelBatch<M>& batch)
+	{
+		static_assert(M <= N, "batch larger than the pipeline");
+		size_t count = batch.count;
+		if (!count)
+			return;
+		accelCalibrate(batch.x, batch.y, batch.z, count, m_cal);
+		if (!m_primed)
+		{
+			m_gravity[0] = batch.x[0];
+			m_gravity[1] = batch.y[0];
+			m_gravity[2] = batch.z[0];
+			m_primed = true;
+		}
+		// single pole IIR; the three independent channel chains are interleaved
+		float gx = m_gravity[0], gy = m_gravity[1], gz = m_gravity[2];
+		const float a = m_alpha;
+		for (size_t i = 0; i < count; i++)
+		{
+			gx += a * (batch.x[i] - gx);
+			gy += a * (batch.y[i] - gy);
+			gz += a * (batch.z[i] - gz);
+			m_gx[i] = gx;
+			m_gy[i] = gy;
+			m_gz[i] = gz;
+		}
+		m_gravity[0] = gx;
+		m_gravity[1] = gy;
+		m_gravity[2] = gz;
+		m_rms = sqrtf(accelSumSquares(batch.x, batch.y, batch.z, m_gx, m_gy, m_gz, count) / static_cast<float>(count));
+		m_roll = atan2f(gy, gz) * kDegrees;
+		m_pitch = atan2f(-gx, sqrtf(gy * gy + gz * gz)) * kDegrees;
+		m_samples += static_cast<unsigned int>(count);
+	}
+
+	/// @brief rotation about the Y axis in degrees, from the gravity estimate at the end of the last batch
+	float pitch() const { return m_pitch; }
+
+	/// @brief rotation about the X axis in degrees
+	float roll() const { return m_roll; }
+
+	/// @brief RMS magnitude of the dynamic acceleration over the last batch, in calibrated units
+	float vibrationRms() const { return m_rms; }
+
+	/// @brief the gravity estimate, index 0..2 for X, Y, Z
+	float gravity(int axis) const { return m_gravity[axis]; }
+
+	/// @brief gravity estimate for each sample of the last batch, the complement of the vibration signal
+	const float* gravityX() const { return m_gx; }
+	const float* gravityY() const { return m_gy; }
+	const float* gravityZ() const { return m_gz; }
+
+	/// @brief samples processed since construction
+	unsigned int samples() const { return m_samples; }
+
+private:
+	AccelFusion(const AccelFusion&);
+	AccelFusion& operator=(const AccelFusion&);
+
+	static constexpr float kDegrees = 57.2957795f;
+
+	AccelCalibration m_cal;
+	float m_alpha;
+	bool m_primed;
+	float m_gravity[3];
+	float m_pitch;
+	float m_roll;
+	float m_rms;
+	unsigned int m_samples;
+	float m_gx[N];
+	float m_gy[N];
+	float m_gz[N];
+};
+
+} // namespace fwwasm
@@ -0,0 +1,409 @@
+/**
+@file
+	@brief Free-Wili wasm arena and pool allocators
+Fixed-capacity allocators backed by static storage so long running scripts do not fragment the WASM linear memory heap.
+A FrameArena is reset once per main loop iteration, FixedPool serves fixed size records (events, log lines) and both keep
+high-water-mark statistics so their capacities can be sized from a real session.
+*/
+#pragma once
+
+#include "fwwasm.h"
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include <new>
+
+#if defined(__has_include)
+#if __has_include(<memory_resource>)
+#include <memory_resource>
+#define FWWASM_HAS_PMR 1
+#endif
+#endif
+
+namespace fwwasm
+{
+
+/**
+ * @brief usage statistics reported by the allocators
+ */
+struct AllocStats
+{
+	size_t capacity;	  ///< total bytes (arena) or blocks (pool) available
+	size_t inUse;		  ///< bytes or blocks currently allocated
+	size_t highWater;	  ///< largest value inUse has reached since the last clearStats()
+	unsigned int allocs;  ///< number of successful allocations
+	unsigned int failures; ///< number of allocations that did not fit
+};
+
+/**
+ * @brief round a value up to a power of two alignment
+ * @param value the value to align
+ * @param align the alignment, must be a power of two
+ */
+inline size_t alignUp(size_t value, size_t align)
+{
+	return (value + (align - 1)) & ~(align - 1);
+}
+
+/**
+ * @brief bump allocator over a fixed byte buffer.
+ *
+ * Allocation is a pointer increment and individual frees are no-ops; call reset() once per loop iteration
+ * (or mark()/rewind() around a scope) to release everything at once.
+ */
+class Arena
+{
+public:
+	/**
+	 * @brief create an arena over caller owned storage
+	 * @param buffer the backing storage
+	 * @param size the size of the backing storage in bytes
+	 */
+	Arena(void* buffer, size_t size) : m_base(static_cast<unsigned char*>(buffer)), m_size(size), m_used(0)
+	{
+		clearStats();
+	}
+
+	/**
+	 * @brief allocate bytes from the arena
+	 * @param bytes the number of bytes to allocate
+	 * @param align the alignment of the allocation, must be a power of two
+	 * @return pointer to the memory or nullptr if the arena is exhausted
+	 */
+	void* allocate(size_t bytes, size_t align = alignof(max_align_t))
+	{
+		uintptr_t base = reinterpret_cast<uintptr_t>(m_base);
+		size_t start = alignUp(base + m_used, align) - base;
+		if (start > m_size || bytes > m_size - start)
+		{
+			m_stats.failures++;
+			return nullptr;
+		}
+		m_used = start + bytes;
+		m_stats.allocs++;
+		if (m_used > m_stats.highWater)
+			m_stats.highWater = m_used;
+		return m_base + start;
+	}
+
+	/**
+	 * @brief allocate and zero an array of objects
+	 * @param count the number of elements
+	 * @return pointer to the array or nullptr if the arena is exhausted
+	 */
+	template <typename T>
+	T* allocArray(size_t count)
+	{
+		if (count > m_size / sizeof(T))
+		{
+			m_stats.failures++;
+			return nullptr;
+		}
+		void* p = allocate(sizeof(T) * count, alignof(T));
+		if (p)
+			memset(p, 0, sizeof(T) * count);
+		return static_cast<T*>(p);
+	}
+
+	/**
+	 * @brief copy a string into the arena
+	 * @param szText the zero terminated string to copy
+	 * @return the copy or nullptr if the arena is exhausted
+	 */
+	char* copyString(const char* szText)
+	{
+		size_t len = strlen(szText) + 1;
+		char* p = static_cast<char*>(allocate(len, 1));
+		if (p)
+			memcpy(p, szText, len);
+		return p;
+	}
+
+	/// @brief the current fill level, for use with rewind()
+	size_t mark() const { return m_used; }
+
+	/// @brief release everything allocated after a mark()
+	void rewind(size_t mark)
+	{
+		if (mark < m_used)
+			m_used = mark;
+	}
+
+	/// @brief release every allocation, typically once per loop iteration
+	void reset() { m_used = 0; }
+
+	/// @brief true if the pointer lies inside the arena storage
+	bool owns(const void* p) const
+	{
+		const unsigned char* c = static_cast<const unsigned char*>(p);
+		return c >= m_base && c < m_base + m_size;
+	}
+
+	/// @brief number of bytes still available (ignoring alignment padding)
+	size_t remaining() const { return m_size - m_used; }
+
+	/// @brief current usage statistics
+	AllocStats stats() const
+	{
+		AllocStats s = m_stats;
+		s.capacity = m_size;
+		s.inUse = m_used;
+		return s;
+	}
+
+	/// @brief clear the high-water mark and counters
+	void clearStats()
+	{
+		memset(&m_stats, 0, sizeof(m_stats));
+		m_stats.highWater = m_used;
+	}
+
+private:
+	unsigned char* m_base;
+	size_t m_size;
+	size_t m_used;
+	AllocStats m_stats;
+};
+
+/**
+ * @brief an Arena with its own static storage.
+ * @tparam SIZE the size of the arena in bytes
+ *
+ * Intended to be declared as a global and reset at the top of the main loop:
+ * @code
+ * static fwwasm::FrameArena<4096> frame;
+ * while (1)
+ * {
+ *     frame.reset();
+ *     char* line = frame.copyString("...");
+ * }
+ * @endcode
+ */
+template <size_t SIZE>
+class FrameArena : public Arena
+{
+public:
+	FrameArena() : Arena(m_storage, SIZE) {}
+
+private:
+	FrameArena(const FrameArena&);
+	FrameArena& operator=(const FrameArena&);
+
+	alignas(max_align_t) unsigned char m_storage[SIZE];
+};
+
+/**
+ * @brief pool of fixed size blocks with an intrusive free list.
+ * @tparam BLOCK_SIZE the size of each block in bytes
+ * @tparam COUNT the number of blocks
+ *
+ * Allocation and release are O(1) and never touch the heap, so event records and log lines can be recycled
+ * indefinitely without fragmenting linear memory.
+ */
+template <size_t BLOCK_SIZE, size_t COUNT>
+class FixedPool
+{
+public:
+	static const size_t kBlockSize = BLOCK_SIZE < sizeof(void*) ? sizeof(void*) : BLOCK_SIZE;
+	static const size_t kStride = (kBlockSize + alignof(max_align_t) - 1) & ~(alignof(max_align_t) - 1);
+	static const size_t kCount = COUNT;
+
+	FixedPool()
+	{
+		m_free = nullptr;
+		for (size_t i = COUNT; i > 0; i--)
+		{
+			FreeNode* node = reinterpret_cast<FreeNode*>(m_storage + (i - 1) * kStride);
+			node->next = m_free;
+			m_free = node;
+		}
+		memset(&m_stats, 0, sizeof(m_stats));
+		m_stats.capacity = COUNT;
+	}
+
+	/**
+	 * @brief take a block from the pool
+	 * @return pointer to a block of BLOCK_SIZE bytes or nullptr if the pool is empty
+	 */
+	void* allocate()
+	{
+		if (!m_free)
+		{
+			m_stats.failures++;
+			return nullptr;
+		}
+		FreeNode* node = m_free;
+		m_free = node->next;
+		m_stats.allocs++;
+		if (++m_stats.inUse > m_stats.highWater)
+			m_stats.highWater = m_stats.inUse;
+		return node;
+	}
+
+	/**
+	 * @brief return a block to the pool
+	 * @param p a block previously returned by allocate(), nullptr is ignored
+	 */
+	void release(void* p)
+	{
+		if (!p)
+			return;
+		FreeNode* node = static_cast<FreeNode*>(p);
+		node->next = m_free;
+		m_free = node;
+		m_stats.inUse--;
+	}
+
+	/// @brief true if the pointer belongs to this pool
+	bool owns(const void* p) const
+	{
+		const unsigned char* c = static_cast<const unsigned char*>(p);
+		return c >= m_storage && c < m_storage + sizeof(m_storage);
+	}
+
+	/// @brief number of blocks still available
+	size_t available() const { return COUNT - m_stats.inUse; }
+
+	/// @brief current usage statistics (counts are in blocks)
+	AllocStats stats() const { return m_stats; }
+
+	/// @brief clear the high-water mark and counters
+	void clearStats()
+	{
+		m_stats.allocs = 0;
+		m_stats.failures = 0;
+		m_stats.highWater = m_stats.inUse;
+	}
+
+private:
+	FixedPool(const FixedPool&);
+	FixedPool& operator=(const FixedPool&);
+
+	struct FreeNode
+	{
+		FreeNode* next;
+	};
+
+	alignas(max_align_t) unsigned char m_storage[kStride * COUNT];
+	FreeNode* m_free;
+	AllocStats m_stats;
+};
+
+/**
+ * @brief typed wrapper around FixedPool that constructs and destroys objects
+ * @tparam T the object type
+ * @tparam COUNT the number of objects
+ */
+template <typename T, size_t COUNT>
+class ObjectPool
+{
+public:
+	/// @brief construct a T in a free block, returns nullptr if the pool is empty
+	template <typename... Args>
+	T* create(Args&&... args)
+	{
+		void* p = m_pool.allocate();
+		return p ? new (p) T(static_cast<Args&&>(args)...) : nullptr;
+	}
+
+	/// @brief destroy an object returned by create()
+	void destroy(T* obj)
+	{
+		if (!obj)
+			return;
+		obj->~T();
+		m_pool.release(obj);
+	}
+
+	size_t available() const { return m_pool.available(); }
+	AllocStats stats() const { return m_pool.stats(); }
+	void clearStats() { m_pool.clearStats(); }
+
+private:
+	FixedPool<sizeof(T), COUNT> m_pool;
+};
+
+#ifdef FWWASM_HAS_PMR
+/**
+ * @brief std::pmr adapter for an Arena.
+ *
+ * Deallocation is a no-op; memory comes back on Arena::reset(). Requests that do not fit are forwarded to the
+ * upstream resource, which defaults to std::pmr::null_memory_resource() so exhaustion is never silently moved to the heap.
+ * @code
+ * static fwwasm::FrameArena<2048> frame;
+ * fwwasm::ArenaResource res(frame);
+ * std::pmr::string line(&res);
+ * @endcode
+ */
+class ArenaResource : public std::pmr::memory_resource
+{
+public:
+	explicit ArenaResource(Arena& arena, std::pmr::memory_resource* upstream = std::pmr::null_memory_resource())
+		: m_arena(arena), m_upstream(upstream)
+	{
+	}
+
+	Arena& arena() { return m_arena; }
+
+private:
+	void* do_allocate(size_t bytes, size_t align) override
+	{
+		void* p = m_arena.allocate(bytes, align);
+		return p ? p : m_upstream->allocate(bytes, align);
+	}
+
+	void do_deallocate(void* p, size_t bytes, size_t align) override
+	{
+		if (!m_arena.owns(p))
+			m_upstream->deallocate(p, bytes, align);
+	}
+
+	bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override { return this == &other; }
+
+	Arena& m_arena;
+	std::pmr::memory_resource* m_upstream;
+};
+
+/**
+ * @brief std::pmr adapter for a FixedPool.
+ *
+ * Requests up to the block size are served from the pool, larger requests (or an empty pool) go to the upstream resource.
+ */
+template <size_t BLOCK_SIZE, size_t COUNT>
+class PoolResource : public std::pmr::memory_resource
+{
+public:
+	explicit PoolResource(FixedPool<BLOCK_SIZE, COUNT>& pool, std::pmr::memory_resource* upstream = std::pmr::null_memory_resource())
+		: m_pool(pool), m_upstream(upstream)
+	{
+	}
+
+private:
+	void* do_allocate(size_t bytes, size_t align) override
+	{
+		if (bytes <= FixedPool<BLOCK_SIZE, COUNT>::kBlockSize && align <= alignof(max_align_t))
+		{
+			void* p = m_pool.allocate();
+			if (p)
+				return p;
+		}
+		return m_upstream->allocate(bytes, align);
+	}
+
+	void do_deallocate(void* p, size_t bytes, size_t align) override
+	{
+		if (m_pool.owns(p))
+			m_pool.release(p);
+		else
+			m_upstream->deallocate(p, bytes, align);
+	}
+
+	bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override { return this == &other; }
+
+	FixedPool<BLOCK_SIZE, COUNT>& m_pool;
+	std::pmr::memory_resource* m_upstream;
+};
+#endif // FWWASM_HAS_PMR
+
+} // namespace fwwasm
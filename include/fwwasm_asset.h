@@ -0,0 +1,354 @@
+/**
+@file
+	@brief Free-Wili wasm read-only asset access
+AssetFile gives random access to a file (lookup tables, fonts, data blobs) through a small cache of fixed-size pages
+that are read with readFile() on first touch, so an asset can be used without copying the whole file into WASM linear
+memory at startup. PictureCache remembers which picture file each control already holds so showing it again only
+changes control properties instead of reloading it from the SD card with addControlPictureFromFile(). The firmware has
+no import to share a loaded picture between controls, so the cache is per control: the same file shown by two controls
+is loaded once into each.
+*/
+#pragma once
+
+#include "fwwasm.h"
+
+#include <stddef.h>
+#include <string.h>
+
+namespace fwwasm
+{
+
+/**
+ * @brief file functions used by AssetFile, defaults to the Free-Wili imports and can be replaced by a host stand-in
+ */
+struct AssetIO
+{
+	int (*read)(int handle, unsigned char* data, int* data_bytes);
+	int (*setPosition)(int handle, int position);
+	int (*getSize)(int handle);
+};
+
+/// @brief AssetIO bound to readFile(), setFilePosition() and getFileSize()
+inline AssetIO defaultAssetIO()
+{
+	AssetIO io = { readFile, setFilePosition, getFileSize };
+	return io;
+}
+
+/**
+ * @brief counters kept by AssetFile
+ */
+struct AssetStats
+{
+	unsigned int hits;		///< page lookups served from the cache
+	unsigned int misses;	///< pages read from the file
+	unsigned int readCalls; ///< readFile() calls made
+	unsigned int bytesRead; ///< bytes read from the file
+};
+
+/**
+ * @brief lazily paged, read-only view of a file.
+ * @tparam PAGE_SIZE bytes per cached page, a multiple of 512 matches SD sectors
+ * @tparam PAGES the number of cached pages; PAGE_SIZE * PAGES is the whole linear memory cost
+ *
+ * @code
+ * static fwwasm::AssetFile<512, 4> table;
+ * table.open(openFile("gamma.bin", mode));
+ * const unsigned char* row = table.window(level * 64, 64); // valid until the next access
+ * @endcode
+ */
+template <size_t PAGE_SIZE = 512, size_t PAGES = 4>
+class AssetFile
+{
+	static_assert(PAGES > 0 && PAGE_SIZE > 0, "AssetFile needs at least one page");
+
+public:
+	explicit AssetFile(AssetIO io = defaultAssetIO()) : m_io(io), m_handle(-1), m_size(0), m_clock(0)
+	{
+		memset(&m_stats, 0, sizeof(m_stats));
+		invalidate();
+	}
+
+	/**
+	 * @brief attach an open file
+	 * @param handle a handle returned by openFile(); AssetFile does not close it
+	 * @return false if the handle is invalid
+	 */
+	bool open(int handle)
+	{
+		invalidate();
+		m_handle = handle;
+		m_size = 0;
+		if (handle < 0)
+			return false;
+		int size = m_io.getSize(handle);
+		if (size < 0)
+			return false;
+		m_size = static_cast<size_t>(size);
+		return true;
+	}
+
+	/// @brief size of the asset in bytes
+	size_t size() const { return m_size; }
+
+	/**
+	 * @brief pointer to a range of the asset without copying it
+	 * @param offset start of the range
+	 * @param length bytes needed, the range must not cross a page boundary
+	 * @return pointer into the page cache, valid until the next access, or nullptr
+	 */
+	const unsigned char* window(size_t offset, size_t length)
+	{
+		if (length == 0 || offset >= m_size || length > m_size - offset || offset / PAGE_SIZE != (offset + length - 1) / PAGE_SIZE)
+			return nullptr;
+		Page* page = load(offset / PAGE_SIZE);
+		return page ? page->data + offset % PAGE_SIZE : nullptr;
+	}
+
+	/**
+	 * @brief copy a range of the asset, crossing pages as needed
+	 * @param offset start of the range
+	 * @param dest destination buffer
+	 * @param length bytes to copy
+	 * @return the number of bytes copied, less than length at the end of the asset
+	 */
+	size_t read(size_t offset, void* dest, size_t length)
+	{
+		unsigned char* out = static_cast<unsigned char*>(dest);
+		size_t done = 0;
+		while (done < length && offset < m_size)
+		{
+			Page* page = load(offset / PAGE_SIZE);
+			if (!page)
+				break;
+			size_t start = offset % PAGE_SIZE;
+			size_t chunk = page->length > start ? page->length - start : 0;
+			if (chunk > length - done)
+				chunk = length - done;
+			if (!chunk)
+				break;
+			memcpy(out + done, page->data + start, chunk);
+			done += chunk;
+			offset += chunk;
+		}
+		return done;
+	}
+
+	/**
+	 * @brief read a little-endian value, e.g. an entry of a lookup table
+	 * @param index element index
+	 * @param fallback returned when the element is outside the asset
+	 */
+	template <typename T>
+	T get(size_t index, T fallback = T())
+	{
+		T value;
+		return read(index * sizeof(T), &value, sizeof(T)) == sizeof(T) ? value : fallback;
+	}
+
+	/// @brief drop every cached page
+	void invalidate()
+	{
+		for (size_t i = 0; i < PAGES; i++)
+		{
+			m_pages[i].number = kNoPage;
+			m_pages[i].length = 0;
+			m_pages[i].lastUse = 0;
+		}
+	}
+
+	AssetStats stats() const { return m_stats; }
+
+private:
+	AssetFile(const AssetFile&);
+	AssetFile& operator=(const AssetFile&);
+
+	static const size_t kNoPage = ~static_cast<size_t>(0);
+
+	struct Page
+	{
+		size_t number;
+		size_t length;
+		unsigned int lastUse;
+		unsigned char data[PAGE_SIZE];
+	};
+
+	Page* load(size_t number)
+	{
+		Page* victim = &m_pages[0];
+		for (size_t i = 0; i < PAGES; i++)
+		{
+			if (m_pages[i].number == number)
+			{
+				m_stats.hits++;
+				m_pages[i].lastUse = ++m_clock;
+				return &m_pages[i];
+			}
+			if (m_pages[i].lastUse < victim->lastUse)
+				victim = &m_pages[i];
+		}
+		m_stats.misses++;
+		victim->number = kNoPage;
+		if (m_handle < 0 || m_io.setPosition(m_handle, static_cast<int>(number * PAGE_SIZE)) <= 0)
+			return nullptr;
+		int bytes = static_cast<int>(PAGE_SIZE);
+		m_stats.readCalls++;
+		if (m_io.read(m_handle, victim->data, &bytes) <= 0 || bytes <= 0)
+			return nullptr;
+		m_stats.bytesRead += static_cast<unsigned int>(bytes);
+		victim->number = number;
+		victim->length = static_cast<size_t>(bytes);
+		victim->lastUse = ++m_clock;
+		return victim;
+	}
+
+	AssetIO m_io;
+	int m_handle;
+	size_t m_size;
+	unsigned int m_clock;
+	AssetStats m_stats;
+	Page m_pages[PAGES];
+};
+
+/**
+ * @brief counters kept by PictureCache
+ */
+struct PictureCacheStats
+{
+	unsigned int loads;	  ///< addControlPictureFromFile() calls made
+	unsigned int reuses;  ///< requests served by changing properties of an already loaded control
+	unsigned int updates; ///< setControlProperty() calls made
+};
+
+/**
+ * @brief avoids reloading a picture file into a control that already holds it.
+ * @tparam ENTRIES the number of picture controls tracked
+ * @tparam NAME_LEN the longest file name tracked, longer names are always loaded
+ *
+ * Use show() wherever addControlPictureFromFile() would be called; if the control already holds the same file only
+ * its position and visibility are updated. Entries are keyed by panel and control, not by file name: showing one file
+ * on two controls loads it into each, and a different file on a tracked control is recognised by its stored name.
+ */
+template <size_t ENTRIES = 16, size_t NAME_LEN = 48>
+class PictureCache
+{
+public:
+	PictureCache() : m_clock(0)
+	{
+		memset(&m_stats, 0, sizeof(m_stats));
+		clear();
+	}
+
+	/**
+	 * @brief show a picture file in a control, loading it only when the control does not hold it yet
+	 * @param panel the index of the panel
+	 * @param control the index of the control
+	 * @param x the x position of the picture
+	 * @param y the y position of the picture
+	 * @param file_name the file in the /images folder
+	 * @param visible if the control should be visible
+	 */
+	void show(int panel, int control, int x, int y, const char* file_name, int visible)
+	{
+		Entry* entry = lookup(panel, control);
+		if (entry && strcmp(entry->name, file_name) == 0)
+		{
+			m_stats.reuses++;
+			if (entry->x != x || entry->y != y)
+			{
+				// fwControlPropertyXY packs x in the high and y in the low 16 bits
+				unsigned int xy = (static_cast<unsigned int>(x) & 0xFFFF) << 16 | (static_cast<unsigned int>(y) & 0xFFFF);
+				setControlProperty(panel, control, fwControlPropertyXY, static_cast<int>(xy));
+				m_stats.updates++;
+			}
+			if (entry->visible != visible)
+			{
+				setControlProperty(panel, control, fwControlPropertyVisible, visible);
+				m_stats.updates++;
+			}
+		}
+		else
+		{
+			addControlPictureFromFile(panel, control, x, y, file_name, visible);
+			m_stats.loads++;
+			if (strlen(file_name) >= NAME_LEN)
+			{
+				if (entry)
+					entry->panel = -1;
+				return;
+			}
+			if (!entry)
+				entry = victim();
+			entry->panel = panel;
+			entry->control = control;
+			strcpy(entry->name, file_name);
+		}
+		entry->x = x;
+		entry->y = y;
+		entry->visible = visible;
+		entry->lastUse = ++m_clock;
+	}
+
+	/// @brief hide a tracked picture control without forgetting its file
+	void hide(int panel, int control)
+	{
+		Entry* entry = lookup(panel, control);
+		if (entry && entry->visible)
+		{
+			setControlProperty(panel, control, fwControlPropertyVisible, 0);
+			entry->visible = 0;
+			m_stats.updates++;
+		}
+	}
+
+	/// @brief forget every control, call when panels are rebuilt
+	void clear()
+	{
+		for (size_t i = 0; i < ENTRIES; i++)
+		{
+			m_entries[i].panel = -1;
+			m_entries[i].lastUse = 0;
+		}
+	}
+
+	PictureCacheStats stats() const { return m_stats; }
+
+private:
+	struct Entry
+	{
+		int panel;
+		int control;
+		int x;
+		int y;
+		int visible;
+		unsigned int lastUse;
+		char name[NAME_LEN];
+	};
+
+	Entry* lookup(int panel, int control)
+	{
+		for (size_t i = 0; i < ENTRIES; i++)
+			if (m_entries[i].panel == panel && m_entries[i].control == control)
+				return &m_entries[i];
+		return nullptr;
+	}
+
+	Entry* victim()
+	{
+		Entry* oldest = &m_entries[0];
+		for (size_t i = 0; i < ENTRIES; i++)
+		{
+			if (m_entries[i].panel < 0)
+				return &m_entries[i];
+			if (m_entries[i].lastUse < oldest->lastUse)
+				oldest = &m_entries[i];
+		}
+		return oldest;
+	}
+
+	unsigned int m_clock;
+	PictureCacheStats m_stats;
+	Entry m_entries[ENTRIES];
+};
+
+} // namespace fwwasm
@@ -0,0 +1,275 @@
+/**
+@file
+	@brief Free-Wili wasm cached directory listing
+getDirectoryItemByIndex() returns one name per call and the firmware walks the directory from the start every time, so
+reading entry i costs i directory reads and a full listing of N entries costs O(N^2). There is no cursor import to
+enumerate in one pass, so DirectoryIndex bounds that cost instead: entries are read only as far as they are asked for
+(the first screen of a long directory needs only the first few, cheap indices), update() reads the rest a few calls per
+frame in the background, and the names are kept in fixed storage so later listings, lookups and iteration are served
+from memory until the file system changes.
+
+The cache is invalidated by the wrappers fwwasm::makeDirectory(), fwwasm::removeFileOrDirectory() and
+fwwasm::renameFileOrDirectory(); code that creates files with openFile() should call invalidateDirectoryIndexes().
+*/
+#pragma once
+
+#include "fwwasm.h"
+
+#include <stddef.h>
+#include <string.h>
+
+#ifndef FWWASM_DIR_NAME_MAX
+/// size of the buffer handed to getDirectoryItemByIndex() for one name
+#define FWWASM_DIR_NAME_MAX 256
+#endif
+
+#ifndef FWWASM_DIR_PATH_MAX
+/// longest directory path a DirectoryIndex keeps, including the terminator
+#define FWWASM_DIR_PATH_MAX 96
+#endif
+
+namespace fwwasm
+{
+
+/// @brief generation counter shared by every DirectoryIndex, bumped whenever the file system changes
+inline unsigned int& directoryGeneration()
+{
+	static unsigned int generation = 1;
+	return generation;
+}
+
+/// @brief mark every DirectoryIndex stale, call after creating or deleting files by other means
+inline void invalidateDirectoryIndexes()
+{
+	directoryGeneration()++;
+}
+
+/// @brief makeDirectory() that also invalidates cached listings
+inline int makeDirectory(const char* file_name)
+{
+	invalidateDirectoryIndexes();
+	return ::makeDirectory(file_name);
+}
+
+/// @brief removeFileOrDirectory() that also invalidates cached listings
+inline int removeFileOrDirectory(const char* file_name)
+{
+	invalidateDirectoryIndexes();
+	return ::removeFileOrDirectory(file_name);
+}
+
+/// @brief renameFileOrDirectory() that also invalidates cached listings
+inline int renameFileOrDirectory(const char* name, const char* new_name)
+{
+	invalidateDirectoryIndexes();
+	return ::renameFileOrDirectory(name, new_name);
+}
+
+/**
+ * @brief signature of the directory enumeration function, matches getDirectoryItemByIndex()
+ */
+typedef int (*DirectoryItemFn)(const char* directory, const char* file_name, int include_extension, int index);
+
+/**
+ * @brief cached listing of one directory.
+ * @tparam MAX_ENTRIES the most names kept
+ * @tparam POOL_BYTES storage for the names including terminators
+ *
+ * @code
+ * static fwwasm::DirectoryIndex<256> recordings;
+ * recordings.open("/recordings", 1);
+ * for (size_t i = 0; i < 8 && recordings.name(i); i++) // first screen, reads only entries 0-7
+ *     setListItemText(log, i, recordings.name(i));
+ * while (1)
+ * {
+ *     recordings.update(4); // the rest of the listing, four reads per frame
+ *     ...
+ * }
+ * @endcode
+ */
+template <size_t MAX_ENTRIES = 128, size_t POOL_BYTES = MAX_ENTRIES * 24>
+class DirectoryIndex
+{
+public:
+	/**
+	 * @brief create an empty index
+	 * @param itemFn the enumeration function, getDirectoryItemByIndex() unless a host stand-in is substituted
+	 */
+	explicit DirectoryIndex(DirectoryItemFn itemFn = getDirectoryItemByIndex)
+		: m_itemFn(itemFn), m_generation(0), m_includeExtension(0), m_count(0), m_used(0), m_atEnd(false), m_truncated(false),
+		  m_calls(0)
+	{
+		m_directory[0] = 0;
+	}
+
+	/**
+	 * @brief select the directory to index; it is read on first use
+	 * @param directory the directory path
+	 * @param include_extension passed through to getDirectoryItemByIndex()
+	 * @return false if the path is FWWASM_DIR_PATH_MAX bytes or longer
+	 */
+	bool open(const char* directory, int include_extension)
+	{
+		size_t len = strlen(directory);
+		if (len >= sizeof(m_directory))
+			return false;
+		if (strcmp(directory, m_directory) != 0 || include_extension != m_includeExtension)
+			m_generation = 0;
+		memcpy(m_directory, directory, len + 1);
+		m_includeExtension = include_extension;
+		return true;
+	}
+
+	/// @brief drop the cached names if the directory changed since they were read
+	void refresh()
+	{
+		if (m_generation == directoryGeneration())
+			return;
+		m_generation = directoryGeneration();
+		m_count = 0;
+		m_used = 0;
+		m_atEnd = !m_directory[0];
+		m_truncated = false;
+	}
+
+	/**
+	 * @brief read more of the listing, call every loop iteration to finish it in the background
+	 * @param maxCalls the most getDirectoryItemByIndex() calls to make
+	 * @return true once the whole listing is cached
+	 */
+	bool update(unsigned int maxCalls)
+	{
+		refresh();
+		for (unsigned int i = 0; i < maxCalls && !m_atEnd; i++)
+			readNext();
+		return m_atEnd;
+	}
+
+	/// @brief number of entries, reading the rest of the directory if needed
+	size_t size()
+	{
+		loadAll();
+		return m_count;
+	}
+
+	/// @brief the name at a position, reading only as far as that position; nullptr when out of range
+	const char* name(size_t index)
+	{
+		loadUntil(index + 1);
+		return index < m_count ? m_pool + m_offsets[index] : nullptr;
+	}
+
+	/**
+	 * @brief position of a name in the listing, reading only until it is found
+	 * @return the index or -1 if the name is not present
+	 */
+	int find(const char* file_name)
+	{
+		refresh();
+		for (size_t i = 0;; i++)
+		{
+			if (i == m_count && (m_atEnd || !readNext()))
+				return -1;
+			if (strcmp(m_pool + m_offsets[i], file_name) == 0)
+				return static_cast<int>(i);
+		}
+	}
+
+	/// @brief false if the directory had more entries than MAX_ENTRIES or POOL_BYTES could hold
+	bool complete()
+	{
+		loadAll();
+		return !m_truncated;
+	}
+
+	/// @brief true when the whole listing is cached and serving it makes no calls
+	bool cached()
+	{
+		refresh();
+		return m_atEnd;
+	}
+
+	/// @brief getDirectoryItemByIndex() calls made so far
+	unsigned int calls() const { return m_calls; }
+
+	/**
+	 * @brief forward iterator over the cached names
+	 */
+	class Iterator
+	{
+	public:
+		Iterator(const DirectoryIndex* index, size_t pos) : m_index(index), m_pos(pos) {}
+		const char* operator*() const { return m_index->m_pool + m_index->m_offsets[m_pos]; }
+		Iterator& operator++()
+		{
+			m_pos++;
+			return *this;
+		}
+		bool operator!=(const Iterator& other) const { return m_pos != other.m_pos; }
+
+	private:
+		const DirectoryIndex* m_index;
+		size_t m_pos;
+	};
+
+	/// @brief iterate over every entry, reading the rest of the directory first
+	Iterator begin()
+	{
+		loadAll();
+		return Iterator(this, 0);
+	}
+	Iterator end() { return Iterator(this, m_count); }
+
+private:
+	DirectoryIndex(const DirectoryIndex&);
+	DirectoryIndex& operator=(const DirectoryIndex&);
+
+	void loadUntil(size_t count)
+	{
+		refresh();
+		while (m_count < count && !m_atEnd)
+			readNext();
+	}
+
+	// one read past the storage tells a full directory from a truncated one
+	void loadAll() { loadUntil(MAX_ENTRIES + 1); }
+
+	// Reads the entry after the cached ones, returns false at the end of the directory or of the storage.
+	bool readNext()
+	{
+		char item[FWWASM_DIR_NAME_MAX];
+		item[0] = 0;
+		m_calls++;
+		if (!m_itemFn(m_directory, item, m_includeExtension, static_cast<int>(m_count)) || !item[0])
+		{
+			m_atEnd = true;
+			return false;
+		}
+		item[sizeof(item) - 1] = 0;
+		size_t len = strlen(item);
+		if (m_count == MAX_ENTRIES || POOL_BYTES - m_used < len + 1)
+		{
+			m_atEnd = true;
+			m_truncated = true;
+			return false;
+		}
+		memcpy(m_pool + m_used, item, len + 1);
+		m_offsets[m_count++] = m_used;
+		m_used += len + 1;
+		return true;
+	}
+
+	DirectoryItemFn m_itemFn;
+	unsigned int m_generation;
+	int m_includeExtension;
+	size_t m_count;
+	size_t m_used;
+	bool m_atEnd;
+	bool m_truncated;
+	unsigned int m_calls;
+	char m_directory[FWWASM_DIR_PATH_MAX];
+	size_t m_offsets[MAX_ENTRIES];
+	char m_pool[POOL_BYTES];
+};
+
+} // namespace fwwasm
@@ -0,0 +1,358 @@
+/**
+@file
+	@brief Free-Wili wasm prioritized event queue
+Drains the firmware event FIFO (hasEvent()/getEventData()) into per-priority lanes on the app side so high-rate
+FWGUI_EVENT_GUI_AUDIO_DATA / FFT / SENSOR_DATA traffic cannot crowd out button presses and FWGUI_EVENT_DIALOG_ACTION.
+Each FWGuiEventType has a lane and a policy:
+ - eventKeepAll queues every event; when the lane is full the oldest queued event that is not eventNeverDrop is
+   dropped, or the new event itself if every queued event is eventNeverDrop
+ - eventKeepLatest replaces a queued event of the same type, so stream data never backs up
+ - eventNeverDrop stops draining the firmware FIFO while the lane is full instead of discarding anything
+Per type counters report delivered, dropped and coalesced events. Helpers can post their own completion events into
+the same queue with post(), using types from FWWASM_APP_EVENT_BASE up. Posted events have their own lane, delivered
+after the high lane and before the normal one; firmware traffic never lands there, so a posted event is never pushed
+out. A full app lane refuses the post, counts it as dropped and returns false so the poster can keep and retry it.
+*/
+#pragma once
+
+#include "fwwasm.h"
+
+#include <stddef.h>
+#include <string.h>
+
+/// @brief first event type for events posted by the app with EventQueue::post(), above every FWGuiEventType
+#define FWWASM_APP_EVENT_BASE 0x100
+
+/// @brief app event types from FWWASM_APP_EVENT_BASE that EventQueue keeps counters for
+#define FWWASM_APP_EVENT_COUNT 16
+
+namespace fwwasm
+{
+
+/**
+ * @brief delivery lanes, lower values are delivered first
+ */
+typedef enum _EventLane
+{
+	eventLaneHigh = 0,
+	eventLaneNormal,
+	eventLaneBulk,
+	eventLaneCount,
+} EventLane;
+
+/**
+ * @brief what happens to an event whose lane is full
+ */
+typedef enum _EventPolicy
+{
+	eventKeepAll = 0,
+	eventKeepLatest,
+	eventNeverDrop,
+} EventPolicy;
+
+/**
+ * @brief one event as returned by getEventData()
+ */
+struct Event
+{
+	int type; ///< see FWGuiEventType
+	unsigned char data[FW_GET_EVENT_DATA_MAX];
+};
+
+/**
+ * @brief per FWGuiEventType and app event type counters
+ */
+struct EventTypeStats
+{
+	unsigned int received;	///< events read from the firmware, or accepted by post() for app types
+	unsigned int delivered; ///< events returned by next()
+	unsigned int dropped;	///< events discarded because their lane was full
+	unsigned int coalesced; ///< events replaced by a newer event of the same type
+};
+
+/**
+ * @brief event functions used by EventQueue, defaults to the Free-Wili imports and can be replaced by a host stand-in
+ */
+struct EventSource
+{
+	int (*hasEvent)(void);
+	int (*getEventData)(unsigned char* data);
+};
+
+/// @brief EventSource bound to hasEvent() and getEventData()
+inline EventSource defaultEventSource()
+{
+	EventSource source = { hasEvent, getEventData };
+	return source;
+}
+
+/**
+ * @brief app side event queue with priority lanes and coalescing.
+ * @tparam HIGH capacity of the high priority lane
+ * @tparam NORMAL capacity of the normal lane
+ * @tparam BULK capacity of the bulk (streaming data) lane
+ * @tparam APP capacity of the lane for events posted with post()
+ *
+ * @code
+ * static fwwasm::EventQueue<> events;
+ * fwwasm::Event ev;
+ * while (1)
+ * {
+ *     while (events.next(ev))
+ *         handle(ev);
+ *     ...
+ * }
+ * @endcode
+ */
+template <size_t HIGH = 16, size_t NORMAL = 16, size_t BULK = 4, size_t APP = 8>
+class EventQueue
+{
+	static_assert(HIGH > 0 && NORMAL > 0 && BULK > 0 && APP > 0, "every lane needs at least one slot");
+
+public:
+	explicit EventQueue(EventSource source = defaultEventSource()) : m_source(source), m_appHead(0), m_appCount(0), m_stashed(false)
+	{
+		memset(m_stats, 0, sizeof(m_stats));
+		memset(m_appStats, 0, sizeof(m_appStats));
+		memset(m_head, 0, sizeof(m_head));
+		memset(m_count, 0, sizeof(m_count));
+		for (int t = 0; t < FWGUI_EVENT_DATA_MAX; t++)
+			setPolicy(t, eventLaneNormal, eventKeepAll);
+		static const int high[] = { FWGUI_EVENT_GRAY_BUTTON, FWGUI_EVENT_YELLOW_BUTTON, FWGUI_EVENT_GREEN_BUTTON, FWGUI_EVENT_BLUE_BUTTON,
+			FWGUI_EVENT_RED_BUTTON, FWGUI_EVENT_IR_CODE, FWGUI_EVENT_GUI_BUTTON, FWGUI_EVENT_GUI_NUMEDIT, FWGUI_EVENT_GUI_TEXTEDIT,
+			FWGUI_EVENT_MAIN_APP_SEL, FWGUI_EVENT_PICKLIST_SEL, FWGUI_EVENT_DIALOG_ACTION, FWGUI_EVENT_M_TERM_INPUT,
+			FWGUI_EVENT_REQUEST_MAIN_RESET, FWGUI_EVENT_REQUEST_MAIN_TEST_CODE, FWGUI_EVENT_REQUEST_ENABLE_DEBUGMODE };
+		for (size_t i = 0; i < sizeof(high) / sizeof(high[0]); i++)
+			setPolicy(high[i], eventLaneHigh, eventNeverDrop);
+		setPolicy(FWGUI_EVENT_GUI_AUDIO_DATA, eventLaneBulk, eventKeepLatest);
+		setPolicy(FWGUI_EVENT_GUI_FFT_DATA, eventLaneBulk, eventKeepLatest);
+		setPolicy(FWGUI_EVENT_GUI_SENSOR_DATA, eventLaneBulk, eventKeepLatest);
+	}
+
+	/**
+	 * @brief change how an event type is queued
+	 * @param type the FWGuiEventType
+	 * @param lane the lane it is delivered from
+	 * @param policy what happens when the lane is full
+	 */
+	void setPolicy(int type, EventLane lane, EventPolicy policy)
+	{
+		if (type < 0 || type >= FWGUI_EVENT_DATA_MAX)
+			return;
+		m_lane[type] = static_cast<unsigned char>(lane);
+		m_policy[type] = static_cast<unsigned char>(policy);
+	}
+
+	/**
+	 * @brief move events from the firmware FIFO into the lanes
+	 * @param maxReads the most getEventData() calls to make
+	 * @return the number of events read
+	 */
+	unsigned int pump(unsigned int maxReads = 64)
+	{
+		if (m_stashed && !enqueue(m_stash))
+			return 0;
+		m_stashed = false;
+		unsigned int reads = 0;
+		while (reads < maxReads && m_source.hasEvent())
+		{
+			Event ev;
+			ev.type = m_source.getEventData(ev.data);
+			reads++;
+			if (ev.type >= 0 && ev.type < FWGUI_EVENT_DATA_MAX)
+				m_stats[ev.type].received++;
+			if (!enqueue(ev))
+			{
+				// lane full and the type must not be dropped: hold it and leave the rest in the firmware FIFO
+				m_stash = ev;
+				m_stashed = true;
+				break;
+			}
+		}
+		return reads;
+	}
+
+	/**
+	 * @brief pump the firmware FIFO and return the highest priority queued event
+	 * @param ev receives the event
+	 * @return false if no event is queued
+	 */
+	bool next(Event& ev)
+	{
+		pump();
+		for (int lane = 0; lane < eventLaneCount; lane++)
+		{
+			if (lane == eventLaneNormal && m_appCount)
+			{
+				ev = m_app[m_appHead];
+				m_appHead = (m_appHead + 1) % APP;
+				m_appCount--;
+				if (EventTypeStats* stats = appStats(ev.type))
+					stats->delivered++;
+				return true;
+			}
+			if (!m_count[lane])
+				continue;
+			ev = slot(lane, m_head[lane]);
+			m_head[lane] = (m_head[lane] + 1) % capacity(lane);
+			m_count[lane]--;
+			if (ev.type >= 0 && ev.type < FWGUI_EVENT_DATA_MAX)
+				m_stats[ev.type].delivered++;
+			return true;
+		}
+		return false;
+	}
+
+	/**
+	 * @brief queue an event raised by the app, next() delivers it like a firmware event
+	 * @param ev the event; a FWGuiEventType uses its own lane, any other type, normally from FWWASM_APP_EVENT_BASE up,
+	 * the app lane
+	 * @return false if the lane is full, the event is then counted as dropped; posted events never push out queued ones
+	 */
+	bool post(const Event& ev)
+	{
+		if (ev.type < 0 || ev.type >= FWGUI_EVENT_DATA_MAX)
+		{
+			EventTypeStats* stats = appStats(ev.type);
+			if (m_appCount == APP)
+			{
+				if (stats)
+					stats->dropped++;
+				return false;
+			}
+			m_app[(m_appHead + m_appCount) % APP] = ev;
+			m_appCount++;
+			if (stats)
+				stats->received++;
+			return true;
+		}
+		int lane = m_lane[ev.type];
+		if (m_count[lane] == capacity(lane))
+		{
+			m_stats[ev.type].dropped++;
+			return false;
+		}
+		return enqueue(ev);
+	}
+
+	/// @brief number of events waiting in the lanes
+	size_t pending() const { return m_count[0] + m_count[1] + m_count[2] + m_appCount + (m_stashed ? 1 : 0); }
+
+	/// @brief counters for one FWGuiEventType, or an app type below FWWASM_APP_EVENT_BASE + FWWASM_APP_EVENT_COUNT
+	EventTypeStats stats(int type) const
+	{
+		EventTypeStats none = { 0, 0, 0, 0 };
+		if (type >= FWWASM_APP_EVENT_BASE && type < FWWASM_APP_EVENT_BASE + FWWASM_APP_EVENT_COUNT)
+			return m_appStats[type - FWWASM_APP_EVENT_BASE];
+		return type >= 0 && type < FWGUI_EVENT_DATA_MAX ? m_stats[type] : none;
+	}
+
+	/// @brief overflow reports from the firmware, FWGUI_EVENT_EVENTFIFO_OVERFLOW plus FWGUI_EVENT_WASM_OVRFLOW
+	unsigned int firmwareOverflows() const
+	{
+		return m_stats[FWGUI_EVENT_EVENTFIFO_OVERFLOW].received + m_stats[FWGUI_EVENT_WASM_OVRFLOW].received;
+	}
+
+	void clearStats()
+	{
+		memset(m_stats, 0, sizeof(m_stats));
+		memset(m_appStats, 0, sizeof(m_appStats));
+	}
+
+private:
+	EventQueue(const EventQueue&);
+	EventQueue& operator=(const EventQueue&);
+
+	EventTypeStats* appStats(int type)
+	{
+		if (type < FWWASM_APP_EVENT_BASE || type >= FWWASM_APP_EVENT_BASE + FWWASM_APP_EVENT_COUNT)
+			return nullptr;
+		return &m_appStats[type - FWWASM_APP_EVENT_BASE];
+	}
+
+	static size_t capacity(int lane) { return lane == eventLaneHigh ? HIGH : (lane == eventLaneNormal ? NORMAL : BULK); }
+
+	Event& slot(int lane, size_t index)
+	{
+		if (lane == eventLaneHigh)
+			return m_high[index];
+		return lane == eventLaneNormal ? m_normal[index] : m_bulk[index];
+	}
+
+	// Returns false only for an eventNeverDrop event whose lane is full.
+	bool enqueue(const Event& ev)
+	{
+		bool known = ev.type >= 0 && ev.type < FWGUI_EVENT_DATA_MAX;
+		int lane = known ? m_lane[ev.type] : static_cast<int>(eventLaneNormal);
+		int policy = known ? m_policy[ev.type] : static_cast<int>(eventKeepAll);
+		size_t cap = capacity(lane);
+		if (policy == eventKeepLatest)
+		{
+			for (size_t i = 0; i < m_count[lane]; i++)
+			{
+				Event& queued = slot(lane, (m_head[lane] + i) % cap);
+				if (queued.type == ev.type)
+				{
+					queued = ev;
+					m_stats[ev.type].coalesced++;
+					return true;
+				}
+			}
+		}
+		if (m_count[lane] == cap)
+		{
+			if (policy == eventNeverDrop)
+				return false;
+			if (!dropOldest(lane))
+			{
+				// setPolicy() can mix policies in a lane; a lane holding only never-drop events loses the new one
+				if (known)
+					m_stats[ev.type].dropped++;
+				return true;
+			}
+		}
+		slot(lane, (m_head[lane] + m_count[lane]) % cap) = ev;
+		m_count[lane]++;
+		return true;
+	}
+
+	// Drops the oldest queued event of a lane that is not eventNeverDrop, false if there is none.
+	bool dropOldest(int lane)
+	{
+		size_t cap = capacity(lane);
+		for (size_t i = 0; i < m_count[lane]; i++)
+		{
+			int type = slot(lane, (m_head[lane] + i) % cap).type;
+			bool known = type >= 0 && type < FWGUI_EVENT_DATA_MAX;
+			if (known && m_policy[type] == eventNeverDrop)
+				continue;
+			if (known)
+				m_stats[type].dropped++;
+			// close the gap by moving the older events up one slot
+			for (size_t j = i; j > 0; j--)
+				slot(lane, (m_head[lane] + j) % cap) = slot(lane, (m_head[lane] + j - 1) % cap);
+			m_head[lane] = (m_head[lane] + 1) % cap;
+			m_count[lane]--;
+			return true;
+		}
+		return false;
+	}
+
+	EventSource m_source;
+	unsigned char m_lane[FWGUI_EVENT_DATA_MAX];
+	unsigned char m_policy[FWGUI_EVENT_DATA_MAX];
+	EventTypeStats m_stats[FWGUI_EVENT_DATA_MAX];
+	EventTypeStats m_appStats[FWWASM_APP_EVENT_COUNT];
+	size_t m_head[eventLaneCount];
+	size_t m_count[eventLaneCount];
+	Event m_high[HIGH];
+	Event m_normal[NORMAL];
+	Event m_bulk[BULK];
+	Event m_app[APP];
+	size_t m_appHead;
+	size_t m_appCount;
+	Event m_stash;
+	bool m_stashed;
+};
+
+} // namespace fwwasm
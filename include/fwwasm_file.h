@@ -0,0 +1,221 @@
+/**
+@file
+	@brief Free-Wili wasm buffered file output
+Collects small writes in a fixed buffer so a file handle from openFile() sees a few large writeFile() calls
+instead of one call per record, plus the CRC-32 used to validate file records.
+
+The file imports do not document their return values. The helpers built on them (here, the journal, the asset cache
+and the FPGA loader) assume a positive result is success and zero or a negative value is a failure.
+*/
+#pragma once
+
+#include "fwwasm.h"
+
+#include <stddef.h>
+#include <string.h>
+
+namespace fwwasm
+{
+
+namespace detail
+{
+
+// little-endian field helpers shared by the file formats
+inline void putU32(unsigned char* out, unsigned int value)
+{
+	out[0] = static_cast<unsigned char>(value);
+	out[1] = static_cast<unsigned char>(value >> 8);
+	out[2] = static_cast<unsigned char>(value >> 16);
+	out[3] = static_cast<unsigned char>(value >> 24);
+}
+
+inline unsigned int getU32(const unsigned char* in)
+{
+	return static_cast<unsigned int>(in[0]) | (static_cast<unsigned int>(in[1]) << 8) | (static_cast<unsigned int>(in[2]) << 16) |
+		(static_cast<unsigned int>(in[3]) << 24);
+}
+
+// LEB128 varints, with zigzag mapping for signed values
+inline unsigned int zigzag(int value)
+{
+	return (static_cast<unsigned int>(value) << 1) ^ static_cast<unsigned int>(value >> 31);
+}
+
+inline int unzigzag(unsigned int value)
+{
+	return static_cast<int>(value >> 1) ^ -static_cast<int>(value & 1);
+}
+
+inline size_t putVarint(unsigned char* out, unsigned int value)
+{
+	size_t n = 0;
+	while (value >= 0x80)
+	{
+		out[n++] = static_cast<unsigned char>(value | 0x80);
+		value >>= 7;
+	}
+	out[n++] = static_cast<unsigned char>(value);
+	return n;
+}
+
+inline bool getVarint(const unsigned char* data, size_t end, size_t& pos, unsigned int& value)
+{
+	value = 0;
+	for (unsigned int shift = 0; shift < 35 && pos < end; shift += 7)
+	{
+		unsigned char b = data[pos++];
+		value |= static_cast<unsigned int>(b & 0x7F) << shift;
+		if (!(b & 0x80))
+			return true;
+	}
+	return false;
+}
+
+} // namespace detail
+
+/**
+ * @brief update a CRC-32 (IEEE 802.3, as used by zip and png) with more data
+ * @param crc the running value, start with 0
+ * @param data the bytes to add
+ * @param length the number of bytes
+ * @return the new running value
+ */
+inline unsigned int crc32Update(unsigned int crc, const void* data, size_t length)
+{
+	// nibble table keeps the code small; fast enough for record sized blocks
+	static const unsigned int table[16] = { 0x00000000, 0x1DB71064, 0x3B6E20C8, 0x26D930AC, 0x76DC4190, 0x6B6B51F4, 0x4DB26158, 0x5005713C,
+		0xEDB88320, 0xF00F9344, 0xD6D6A3E8, 0xCB61B38C, 0x9B64C2B0, 0x86D3D2D4, 0xA00AE278, 0xBDBDF21C };
+	const unsigned char* p = static_cast<const unsigned char*>(data);
+	crc = ~crc;
+	for (size_t i = 0; i < length; i++)
+	{
+		crc = table[(crc ^ p[i]) & 0x0F] ^ (crc >> 4);
+		crc = table[(crc ^ (p[i] >> 4)) & 0x0F] ^ (crc >> 4);
+	}
+	return ~crc;
+}
+
+/**
+ * @brief counters kept by BufferedFileWriter
+ */
+struct FileWriterStats
+{
+	unsigned int bytes;		 ///< bytes accepted by write()
+	unsigned int written;	 ///< bytes accepted by writeFile(), lost blocks excluded
+	unsigned int writeCalls; ///< writeFile() calls made
+	unsigned int failures;	 ///< writeFile() calls that reported an error
+};
+
+/**
+ * @brief signature of the function used to write a block to a file, matches writeFile()
+ */
+typedef int (*FileWriteFn)(int handle, unsigned char* data, int data_bytes);
+
+/**
+ * @brief write-behind buffer in front of writeFile().
+ * @tparam SIZE the buffer size in bytes, a multiple of the SD sector size (512) works best
+ *
+ * The writer does not own the handle; call flush() before closeFile().
+ */
+template <size_t SIZE>
+class BufferedFileWriter
+{
+public:
+	/**
+	 * @brief create a writer
+	 * @param handle a handle returned by openFile(), or -1 to attach one later with setHandle()
+	 * @param writeFn the write function, writeFile() unless a host stand-in is substituted
+	 */
+	explicit BufferedFileWriter(int handle = -1, FileWriteFn writeFn = writeFile) : m_handle(handle), m_used(0), m_write(writeFn)
+	{
+		memset(&m_stats, 0, sizeof(m_stats));
+	}
+
+	/// @brief flush pending data and switch to another handle
+	void setHandle(int handle)
+	{
+		flush();
+		m_handle = handle;
+	}
+
+	int handle() const { return m_handle; }
+
+	/**
+	 * @brief queue bytes for the file, writing the buffer out when it fills
+	 * @param data the bytes to write
+	 * @param length the number of bytes
+	 * @return true if everything written so far was accepted by writeFile()
+	 */
+	bool write(const void* data, size_t length)
+	{
+		const unsigned char* p = static_cast<const unsigned char*>(data);
+		bool ok = true;
+		m_stats.bytes += static_cast<unsigned int>(length);
+		// large blocks skip the copy once the buffer is empty
+		if (m_used == 0 && length >= SIZE)
+			return writeBlock(p, length);
+		while (length)
+		{
+			size_t chunk = SIZE - m_used;
+			if (chunk > length)
+				chunk = length;
+			memcpy(m_buffer + m_used, p, chunk);
+			m_used += chunk;
+			p += chunk;
+			length -= chunk;
+			if (m_used == SIZE)
+				ok = flush() && ok;
+		}
+		return ok;
+	}
+
+	/// @brief queue a zero terminated string without its terminator
+	bool writeString(const char* szText) { return write(szText, strlen(szText)); }
+
+	/**
+	 * @brief hand any buffered bytes to writeFile()
+	 * @return true on success or when nothing was pending
+	 */
+	bool flush()
+	{
+		if (!m_used)
+			return true;
+		bool ok = writeBlock(m_buffer, m_used);
+		m_used = 0;
+		return ok;
+	}
+
+	/// @brief number of bytes waiting in the buffer
+	size_t pending() const { return m_used; }
+
+	FileWriterStats stats() const { return m_stats; }
+
+private:
+	BufferedFileWriter(const BufferedFileWriter&);
+	BufferedFileWriter& operator=(const BufferedFileWriter&);
+
+	bool writeBlock(const unsigned char* data, size_t length)
+	{
+		if (m_handle < 0)
+		{
+			m_stats.failures++;
+			return false;
+		}
+		m_stats.writeCalls++;
+		if (m_write(m_handle, const_cast<unsigned char*>(data), static_cast<int>(length)) <= 0)
+		{
+			m_stats.failures++;
+			return false;
+		}
+		m_stats.written += static_cast<unsigned int>(length);
+		return true;
+	}
+
+	int m_handle;
+	size_t m_used;
+	FileWriteFn m_write;
+	FileWriterStats m_stats;
+	unsigned char m_buffer[SIZE];
+};
+
+} // namespace fwwasm
@@ -0,0 +1,710 @@
+/**
+@file
+	@brief Free-Wili wasm allocation-free text formatting
+Formats several values into a caller supplied buffer in one pass and emits the finished line with a single call to
+printInt(), setLogDataText() or setControlValueText(). Format strings use `{}` placeholders, are parsed when the
+format object is constructed (at compile time with C++20) and never touch the heap.
+
+Placeholder grammar: `{` [`:` [align][`0`][width][`.`precision][type]] `}`
+ - align: `<` left, `>` right (numbers default right, text defaults left)
+ - `0`: pad numbers with zeros instead of spaces
+ - precision: digits after the decimal point for floats (default 2)
+ - type: `d` decimal, `x`/`X` hex, `b` binary, `c` character, `s` text, `f` fixed-point float
+ - negative integers in hex or binary show the bits of their own width; floats too large for 64 bit fixed point
+   switch to `d.dde+N`
+ - `{{` and `}}` emit literal braces
+*/
+#pragma once
+
+#include "fwwasm.h"
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifndef FWWASM_FORMAT_LINE_MAX
+/// size of the stack buffer used by print(), logText() and setControlText()
+#define FWWASM_FORMAT_LINE_MAX 128
+#endif
+
+#if defined(__cpp_consteval)
+#define FWWASM_CONSTEVAL consteval
+#else
+#define FWWASM_CONSTEVAL constexpr
+#endif
+
+namespace fwwasm
+{
+
+/**
+ * @brief bounded character sink used by the formatter.
+ *
+ * Output past the capacity is dropped and flagged, the buffer is always zero terminated.
+ */
+class FormatBuffer
+{
+public:
+	/**
+	 * @brief wrap caller storage
+	 * @param buffer the destination
+	 * @param size the size of the destination including the terminator, must be at least 1
+	 */
+	FormatBuffer(char* buffer, size_t size) : m_buf(buffer), m_cap(size - 1), m_len(0), m_truncated(false), m_escapePercent(false)
+	{
+		m_buf[0] = 0;
+	}
+
+	void put(char c)
+	{
+		if (m_escapePercent && c == '%')
+		{
+			// an escaped '%' is written as a pair or not at all, a lone '%' would start a format spec
+			if (m_truncated || m_cap - m_len < 2)
+			{
+				m_truncated = true;
+				return;
+			}
+			putRaw('%');
+		}
+		putRaw(c);
+	}
+
+	void put(const char* text, size_t len)
+	{
+		for (size_t i = 0; i < len; i++)
+			put(text[i]);
+	}
+
+	void fill(char c, size_t count)
+	{
+		for (size_t i = 0; i < count; i++)
+			put(c);
+	}
+
+	/// @brief double every '%' so the result can be passed as a printf style format spec
+	void setEscapePercent(bool escape) { m_escapePercent = escape; }
+
+	void clear()
+	{
+		m_len = 0;
+		m_truncated = false;
+		m_buf[0] = 0;
+	}
+
+	const char* c_str() const { return m_buf; }
+	size_t length() const { return m_len; }
+	/// @brief true if output was dropped because the buffer was full
+	bool truncated() const { return m_truncated; }
+
+private:
+	// once anything was dropped nothing more is appended, so the output is always a prefix of the full text
+	void putRaw(char c)
+	{
+		if (!m_truncated && m_len < m_cap)
+		{
+			m_buf[m_len++] = c;
+			m_buf[m_len] = 0;
+		}
+		else
+			m_truncated = true;
+	}
+
+	char* m_buf;
+	size_t m_cap;
+	size_t m_len;
+	bool m_truncated;
+	bool m_escapePercent;
+};
+
+/**
+ * @brief a FormatBuffer with its own storage
+ * @tparam SIZE the storage size including the terminator
+ */
+template <size_t SIZE>
+class FixedString : public FormatBuffer
+{
+public:
+	FixedString() : FormatBuffer(m_storage, SIZE) {}
+	FixedString(const FixedString& other) : FormatBuffer(m_storage, SIZE) { put(other.c_str(), other.length()); }
+
+private:
+	FixedString& operator=(const FixedString&);
+
+	char m_storage[SIZE];
+};
+
+/**
+ * @brief parsed form of one placeholder
+ */
+struct FormatSpec
+{
+	unsigned short start = 0; ///< offset of the opening brace
+	unsigned short end = 0;	  ///< offset just past the closing brace
+	char align = 0;			  ///< '<', '>' or 0 for the default
+	char fill = ' ';		  ///< ' ' or '0'
+	unsigned char width = 0;
+	signed char precision = -1; ///< -1 when not given
+	char type = 0;				///< conversion character or 0 for the default
+};
+
+/**
+ * @brief kinds of argument the formatter accepts
+ */
+enum FormatArgKind
+{
+	fmtArgInt,
+	fmtArgUInt,
+	fmtArgFloat,
+	fmtArgChar,
+	fmtArgBool,
+	fmtArgString,
+	fmtArgUnsupported,
+};
+
+namespace detail
+{
+
+template <typename T>
+struct Identity
+{
+	typedef T type;
+};
+
+template <typename T>
+struct ArgKindOf
+{
+	static const FormatArgKind value = fmtArgUnsupported;
+};
+#define FWWASM_FORMAT_KIND(TYPE, KIND) \
+	template <> \
+	struct ArgKindOf<TYPE> \
+	{ \
+		static const FormatArgKind value = KIND; \
+	}
+FWWASM_FORMAT_KIND(signed char, fmtArgInt);
+FWWASM_FORMAT_KIND(short, fmtArgInt);
+FWWASM_FORMAT_KIND(int, fmtArgInt);
+FWWASM_FORMAT_KIND(long, fmtArgInt);
+FWWASM_FORMAT_KIND(long long, fmtArgInt);
+FWWASM_FORMAT_KIND(unsigned char, fmtArgUInt);
+FWWASM_FORMAT_KIND(unsigned short, fmtArgUInt);
+FWWASM_FORMAT_KIND(unsigned int, fmtArgUInt);
+FWWASM_FORMAT_KIND(unsigned long, fmtArgUInt);
+FWWASM_FORMAT_KIND(unsigned long long, fmtArgUInt);
+FWWASM_FORMAT_KIND(float, fmtArgFloat);
+FWWASM_FORMAT_KIND(double, fmtArgFloat);
+FWWASM_FORMAT_KIND(char, fmtArgChar);
+FWWASM_FORMAT_KIND(bool, fmtArgBool);
+FWWASM_FORMAT_KIND(const char*, fmtArgString);
+FWWASM_FORMAT_KIND(char*, fmtArgString);
+#undef FWWASM_FORMAT_KIND
+
+template <typename T>
+struct ArgKind : ArgKindOf<T>
+{
+};
+template <typename T>
+struct ArgKind<const T> : ArgKind<T>
+{
+};
+template <size_t N>
+struct ArgKind<char[N]> : ArgKindOf<const char*>
+{
+};
+template <typename E>
+struct EnumKind
+{
+	static const FormatArgKind value = __is_enum(E) ? fmtArgInt : fmtArgUnsupported;
+};
+
+template <typename T>
+constexpr FormatArgKind argKind()
+{
+	return ArgKind<T>::value != fmtArgUnsupported ? ArgKind<T>::value : EnumKind<T>::value;
+}
+
+// Reached only when a format string fails validation; not constexpr, so the failure becomes a compile error.
+inline void formatStringError(const char*) {}
+
+constexpr bool typeAllowed(char type, FormatArgKind kind)
+{
+	switch (type)
+	{
+		case 0:
+			return true;
+		case 'd':
+		case 'x':
+		case 'X':
+		case 'b':
+			return kind == fmtArgInt || kind == fmtArgUInt || kind == fmtArgChar || kind == fmtArgBool;
+		case 'c':
+			return kind == fmtArgInt || kind == fmtArgUInt || kind == fmtArgChar;
+		case 'f':
+			return kind == fmtArgFloat || kind == fmtArgInt || kind == fmtArgUInt;
+		case 's':
+			return kind == fmtArgString || kind == fmtArgBool;
+		default:
+			return false;
+	}
+}
+
+} // namespace detail
+
+/**
+ * @brief a format string checked against its argument types.
+ *
+ * Constructed implicitly from a string literal; with C++20 an invalid placeholder, a type mismatch or a wrong
+ * argument count fails to compile. The placeholder positions are stored so formatting does not re-parse the string.
+ */
+template <typename... Args>
+class FormatString
+{
+public:
+	static const size_t kArgCount = sizeof...(Args);
+
+	template <size_t N>
+	FWWASM_CONSTEVAL FormatString(const char (&text)[N]) : m_text(text), m_length(N - 1), m_specs()
+	{
+		const FormatArgKind kinds[kArgCount + 1] = { detail::argKind<Args>()..., fmtArgUnsupported };
+		size_t arg = 0;
+		for (size_t i = 0; i < N - 1; i++)
+		{
+			if (text[i] == '}')
+			{
+				if (i + 1 < N - 1 && text[i + 1] == '}')
+					i++;
+				else
+					detail::formatStringError("unmatched '}' in format string");
+				continue;
+			}
+			if (text[i] != '{')
+				continue;
+			if (i + 1 < N - 1 && text[i + 1] == '{')
+			{
+				i++;
+				continue;
+			}
+			if (arg >= kArgCount)
+			{
+				detail::formatStringError("more placeholders than arguments");
+				break;
+			}
+			FormatSpec spec;
+			spec.start = static_cast<unsigned short>(i);
+			size_t p = i + 1;
+			if (p < N - 1 && text[p] == ':')
+			{
+				p++;
+				if (p < N - 1 && (text[p] == '<' || text[p] == '>'))
+					spec.align = text[p++];
+				if (p < N - 1 && text[p] == '0')
+				{
+					spec.fill = '0';
+					p++;
+				}
+				unsigned int width = 0;
+				while (p < N - 1 && text[p] >= '0' && text[p] <= '9')
+					width = width * 10 + static_cast<unsigned int>(text[p++] - '0');
+				if (width > 255)
+					detail::formatStringError("width too large");
+				spec.width = static_cast<unsigned char>(width);
+				if (p < N - 1 && text[p] == '.')
+				{
+					p++;
+					int precision = 0;
+					while (p < N - 1 && text[p] >= '0' && text[p] <= '9')
+						precision = precision * 10 + (text[p++] - '0');
+					if (precision > 9)
+						detail::formatStringError("precision must be 0-9");
+					spec.precision = static_cast<signed char>(precision);
+				}
+				if (p < N - 1 && text[p] != '}')
+					spec.type = text[p++];
+			}
+			if (p >= N - 1 || text[p] != '}')
+			{
+				detail::formatStringError("malformed placeholder");
+				break;
+			}
+			if (kinds[arg] == fmtArgUnsupported)
+				detail::formatStringError("unsupported argument type");
+			if (!detail::typeAllowed(spec.type, kinds[arg]))
+				detail::formatStringError("placeholder type does not match argument");
+			spec.end = static_cast<unsigned short>(p + 1);
+			m_specs[arg++] = spec;
+			i = p;
+		}
+		if (arg != kArgCount)
+			detail::formatStringError("fewer placeholders than arguments");
+	}
+
+	const char* text() const { return m_text; }
+	size_t length() const { return m_length; }
+	const FormatSpec* specs() const { return m_specs; }
+
+private:
+	const char* m_text;
+	size_t m_length;
+	FormatSpec m_specs[kArgCount + 1];
+};
+
+/**
+ * @brief type erased argument passed to the non-template formatting core
+ */
+struct FormatArg
+{
+	FormatArgKind kind;
+	unsigned char bytes; ///< sizeof the original argument, hex and binary show negative values at this width
+	union
+	{
+		long long i;
+		unsigned long long u;
+		double f;
+		const char* s;
+	};
+
+	template <typename T>
+	static FormatArg make(const T& value)
+	{
+		FormatArg a;
+		a.kind = detail::argKind<T>();
+		a.bytes = static_cast<unsigned char>(sizeof(T));
+		switch (a.kind)
+		{
+			case fmtArgUInt:
+				a.u = static_cast<unsigned long long>(value);
+				break;
+			case fmtArgFloat:
+				a.f = static_cast<double>(value);
+				break;
+			default:
+				a.i = static_cast<long long>(value);
+				break;
+		}
+		return a;
+	}
+	static FormatArg make(const char* value)
+	{
+		FormatArg a;
+		a.kind = fmtArgString;
+		a.bytes = sizeof(value);
+		a.s = value ? value : "(null)";
+		return a;
+	}
+	static FormatArg make(char* value) { return make(static_cast<const char*>(value)); }
+	template <size_t N>
+	static FormatArg make(const char (&value)[N])
+	{
+		return make(static_cast<const char*>(value));
+	}
+};
+
+namespace detail
+{
+
+inline void padded(FormatBuffer& out, const FormatSpec& spec, const char* text, size_t len, bool numeric, size_t signLen)
+{
+	size_t pad = spec.width > len ? spec.width - len : 0;
+	bool left = spec.align == '<' || (spec.align == 0 && !numeric);
+	if (!pad)
+	{
+		out.put(text, len);
+		return;
+	}
+	if (left)
+	{
+		out.put(text, len);
+		out.fill(' ', pad);
+	}
+	else if (spec.fill == '0' && numeric)
+	{
+		// zeros go between the sign and the digits
+		out.put(text, signLen);
+		out.fill('0', pad);
+		out.put(text + signLen, len - signLen);
+	}
+	else
+	{
+		out.fill(' ', pad);
+		out.put(text, len);
+	}
+}
+
+// Writes digits right aligned into the end of tmp and returns the first character.
+inline char* utoa(char* end, unsigned long long value, unsigned int base, bool upper)
+{
+	const char* digits = upper ? "0123456789ABCDEF" : "0123456789abcdef";
+	char* p = end;
+	do
+	{
+		*--p = digits[value % base];
+		value /= base;
+	} while (value);
+	return p;
+}
+
+inline void formatInteger(FormatBuffer& out, const FormatSpec& spec, bool negative, unsigned long long magnitude)
+{
+	char tmp[68];
+	char* end = tmp + sizeof(tmp);
+	unsigned int base = 10;
+	if (spec.type == 'x' || spec.type == 'X')
+		base = 16;
+	else if (spec.type == 'b')
+		base = 2;
+	char* p = utoa(end, magnitude, base, spec.type == 'X');
+	if (negative)
+		*--p = '-';
+	padded(out, spec, p, static_cast<size_t>(end - p), true, negative ? 1 : 0);
+}
+
+inline void formatFloat(FormatBuffer& out, const FormatSpec& spec, double value)
+{
+	char tmp[48];
+	char* end = tmp + sizeof(tmp);
+	char* p = end;
+	int precision = spec.precision < 0 ? 2 : spec.precision;
+	bool negative = value < 0;
+	double magnitude = negative ? -value : value;
+	if (value != value)
+	{
+		padded(out, spec, "nan", 3, true, 0);
+		return;
+	}
+	if (magnitude - magnitude != 0)
+	{
+		const char* text = negative ? "-inf" : "inf";
+		padded(out, spec, text, negative ? 4 : 3, true, negative ? 1 : 0);
+		return;
+	}
+	unsigned long long scale = 1;
+	for (int i = 0; i < precision; i++)
+		scale *= 10;
+	// fixed point conversion needs the scaled value in 64 bits, larger values are shown as d.ddde+N
+	int exponent = -1;
+	if (magnitude * static_cast<double>(scale) >= 1.8e19)
+	{
+		exponent = 0;
+		while (magnitude >= 1e16)
+		{
+			magnitude /= 1e16;
+			exponent += 16;
+		}
+		while (magnitude >= 10)
+		{
+			magnitude /= 10;
+			exponent++;
+		}
+	}
+	unsigned long long fixed = static_cast<unsigned long long>(magnitude * static_cast<double>(scale) + 0.5);
+	if (exponent >= 0)
+	{
+		// rounding can carry into a second integer digit
+		if (fixed >= 10 * scale)
+		{
+			fixed /= 10;
+			exponent++;
+		}
+		p = utoa(p, static_cast<unsigned long long>(exponent), 10, false);
+		*--p = '+';
+		*--p = 'e';
+	}
+	unsigned long long whole = fixed / scale;
+	unsigned long long frac = fixed % scale;
+	if (precision > 0)
+	{
+		for (int i = 0; i < precision; i++)
+		{
+			*--p = static_cast<char>('0' + frac % 10);
+			frac /= 10;
+		}
+		*--p = '.';
+	}
+	p = utoa(p, whole, 10, false);
+	if (negative && fixed)
+		*--p = '-';
+	padded(out, spec, p, static_cast<size_t>(end - p), true, *p == '-' ? 1 : 0);
+}
+
+// All ones in the low bytes of a value, so a sign extended negative argument keeps its own width in hex and binary.
+inline unsigned long long widthMask(unsigned char bytes)
+{
+	return bytes >= sizeof(unsigned long long) ? ~0ull : (1ull << (bytes * 8)) - 1;
+}
+
+inline void formatArg(FormatBuffer& out, const FormatSpec& spec, const FormatArg& arg)
+{
+	switch (arg.kind)
+	{
+		case fmtArgInt:
+		case fmtArgChar:
+		case fmtArgBool:
+			if (spec.type == 'c' || (arg.kind == fmtArgChar && spec.type == 0))
+			{
+				char c = static_cast<char>(arg.i);
+				padded(out, spec, &c, 1, false, 0);
+			}
+			else if (arg.kind == fmtArgBool && (spec.type == 0 || spec.type == 's'))
+				padded(out, spec, arg.i ? "true" : "false", arg.i ? 4 : 5, false, 0);
+			else if (spec.type == 'f')
+				formatFloat(out, spec, static_cast<double>(arg.i));
+			else if (arg.i < 0 && spec.type != 'x' && spec.type != 'X' && spec.type != 'b')
+				formatInteger(out, spec, true, 0ull - static_cast<unsigned long long>(arg.i));
+			else
+				formatInteger(out, spec, false, static_cast<unsigned long long>(arg.i) & widthMask(arg.bytes));
+			break;
+		case fmtArgUInt:
+			if (spec.type == 'c')
+			{
+				char c = static_cast<char>(arg.u);
+				padded(out, spec, &c, 1, false, 0);
+			}
+			else if (spec.type == 'f')
+				formatFloat(out, spec, static_cast<double>(arg.u));
+			else
+				formatInteger(out, spec, false, arg.u);
+			break;
+		case fmtArgFloat:
+			formatFloat(out, spec, arg.f);
+			break;
+		case fmtArgString:
+		{
+			size_t len = 0;
+			while (arg.s[len])
+				len++;
+			if (spec.precision >= 0 && static_cast<size_t>(spec.precision) < len)
+				len = static_cast<size_t>(spec.precision);
+			padded(out, spec, arg.s, len, false, 0);
+			break;
+		}
+		default:
+			out.put("{?}", 3);
+			break;
+	}
+}
+
+// Appends literal text, collapsing doubled braces.
+inline void formatLiteral(FormatBuffer& out, const char* text, size_t begin, size_t end)
+{
+	for (size_t i = begin; i < end; i++)
+	{
+		out.put(text[i]);
+		if ((text[i] == '{' || text[i] == '}') && i + 1 < end && text[i + 1] == text[i])
+			i++;
+	}
+}
+
+} // namespace detail
+
+/**
+ * @brief format type erased arguments using pre-parsed placeholders
+ * @param out destination buffer
+ * @param text the format string
+ * @param length length of the format string
+ * @param specs placeholder positions and options, one per argument
+ * @param args the arguments
+ * @param count number of arguments
+ */
+inline void vformatTo(FormatBuffer& out, const char* text, size_t length, const FormatSpec* specs, const FormatArg* args, size_t count)
+{
+	size_t pos = 0;
+	for (size_t i = 0; i < count; i++)
+	{
+		detail::formatLiteral(out, text, pos, specs[i].start);
+		detail::formatArg(out, specs[i], args[i]);
+		pos = specs[i].end;
+	}
+	detail::formatLiteral(out, text, pos, length);
+}
+
+/**
+ * @brief append formatted text to a buffer
+ * @return the number of characters in the buffer
+ */
+template <typename... Args>
+size_t formatTo(FormatBuffer& out, FormatString<typename detail::Identity<Args>::type...> fmt, const Args&... args)
+{
+	const FormatArg packed[sizeof...(Args) + 1] = { FormatArg::make(args)..., FormatArg::make("") };
+	vformatTo(out, fmt.text(), fmt.length(), fmt.specs(), packed, sizeof...(Args));
+	return out.length();
+}
+
+/**
+ * @brief format into a plain character array
+ * @param buffer the destination, always zero terminated
+ * @param size the size of the destination
+ * @return the number of characters written, excluding the terminator
+ */
+template <typename... Args>
+size_t formatTo(char* buffer, size_t size, FormatString<typename detail::Identity<Args>::type...> fmt, const Args&... args)
+{
+	FormatBuffer out(buffer, size);
+	const FormatArg packed[sizeof...(Args) + 1] = { FormatArg::make(args)..., FormatArg::make("") };
+	vformatTo(out, fmt.text(), fmt.length(), fmt.specs(), packed, sizeof...(Args));
+	return out.length();
+}
+
+/**
+ * @brief format into a FixedString returned by value
+ * @tparam SIZE the capacity of the result including the terminator
+ */
+template <size_t SIZE = FWWASM_FORMAT_LINE_MAX, typename... Args>
+FixedString<SIZE> format(FormatString<typename detail::Identity<Args>::type...> fmt, const Args&... args)
+{
+	FixedString<SIZE> out;
+	const FormatArg packed[sizeof...(Args) + 1] = { FormatArg::make(args)..., FormatArg::make("") };
+	vformatTo(out, fmt.text(), fmt.length(), fmt.specs(), packed, sizeof...(Args));
+	return out;
+}
+
+/**
+ * @brief format a line and print it to the debug terminal with one printInt() call
+ * @param iColor the color of the line. See printOutColor enum for more details.
+ */
+template <typename... Args>
+void print(printOutColor iColor, FormatString<typename detail::Identity<Args>::type...> fmt, const Args&... args)
+{
+	FixedString<FWWASM_FORMAT_LINE_MAX> out;
+	// the line is used as printInt's format spec so literal '%' must be doubled
+	out.setEscapePercent(true);
+	const FormatArg packed[sizeof...(Args) + 1] = { FormatArg::make(args)..., FormatArg::make("") };
+	vformatTo(out, fmt.text(), fmt.length(), fmt.specs(), packed, sizeof...(Args));
+	printInt(out.c_str(), iColor, printInt32, 0);
+}
+
+/**
+ * @brief format a line and print it to the debug terminal in the normal color
+ */
+template <typename... Args>
+void print(FormatString<typename detail::Identity<Args>::type...> fmt, const Args&... args)
+{
+	print<Args...>(printColorNormal, fmt, args...);
+}
+
+/**
+ * @brief format a line and append it to a log control with one setLogDataText() call
+ * @param log the index of the log
+ */
+template <typename... Args>
+void logText(int log, FormatString<typename detail::Identity<Args>::type...> fmt, const Args&... args)
+{
+	FixedString<FWWASM_FORMAT_LINE_MAX> out;
+	const FormatArg packed[sizeof...(Args) + 1] = { FormatArg::make(args)..., FormatArg::make("") };
+	vformatTo(out, fmt.text(), fmt.length(), fmt.specs(), packed, sizeof...(Args));
+	setLogDataText(log, out.c_str());
+}
+
+/**
+ * @brief format text and set it as a control value with one setControlValueText() call
+ * @param panel the index of the panel
+ * @param control the index of the control
+ */
+template <typename... Args>
+void setControlText(int panel, int control, FormatString<typename detail::Identity<Args>::type...> fmt, const Args&... args)
+{
+	FixedString<FWWASM_FORMAT_LINE_MAX> out;
+	const FormatArg packed[sizeof...(Args) + 1] = { FormatArg::make(args)..., FormatArg::make("") };
+	vformatTo(out, fmt.text(), fmt.length(), fmt.specs(), packed, sizeof...(Args));
+	setControlValueText(panel, control, out.c_str());
+}
+
+} // namespace fwwasm
@@ -0,0 +1,360 @@
+/**
+@file
+	@brief Free-Wili wasm chunked FPGA image loading
+loadFPGAFromFile() only takes a file name and blocks until the FPGA is configured. FpgaLoader splits the work around
+it: a bitstream from WASM memory, another open file or chunks the app receives itself (UART, radio) is written to a
+staging file one chunk per step() so the main loop keeps running, the CRC-32 is computed on the way through so the
+image is verified without reading it back, and progress is reported in whole percent, ready for
+setProgressDialogValue(). A failed load reports FWWASM_FPGA_PROGRESS_FAILED, which fpgaProgressDialog() turns into 100 so a
+dialog opened with auto_close_at_100 closes; the app then shows error() its own way. Only the final loadFPGAFromFile()
+call blocks.
+
+@code
+static fwwasm::FpgaLoader<> fpga;
+showDialogProgressBar("Loading FPGA", 0, 0, 1, 2);
+fpga.onProgress(fwwasm::fpgaProgressDialog, nullptr);
+fpga.beginFromMemory(kImage, sizeof(kImage), openFile("stage.bit", mode), "stage.bit", kImageCrc, true);
+while (fpga.state() == fwwasm::fpgaStaging)
+{
+	fpga.step();
+	... // keep handling events
+}
+@endcode
+*/
+#pragma once
+
+#include "fwwasm.h"
+#include "fwwasm_file.h"
+
+#include <stddef.h>
+#include <string.h>
+
+/// @brief percent passed to the progress callback when the load fails
+#define FWWASM_FPGA_PROGRESS_FAILED -1
+
+namespace fwwasm
+{
+
+/**
+ * @brief functions used by FpgaLoader, defaults to the Free-Wili imports and can be replaced by a host stand-in
+ */
+struct FpgaIO
+{
+	FileWriteFn write;
+	int (*read)(int handle, unsigned char* data, int* data_bytes);
+	int (*preAllocate)(int handle, int size_in_bytes);
+	int (*close)(int handle);
+	int (*load)(const char* file_name);
+};
+
+/// @brief FpgaIO bound to writeFile(), readFile(), preAllocateSpaceForFile(), closeFile() and loadFPGAFromFile()
+inline FpgaIO defaultFpgaIO()
+{
+	FpgaIO io = { writeFile, readFile, preAllocateSpaceForFile, closeFile, loadFPGAFromFile };
+	return io;
+}
+
+/**
+ * @brief where an FpgaLoader is in a load
+ */
+typedef enum _FpgaLoadState
+{
+	fpgaIdle = 0, ///< nothing started
+	fpgaStaging,  ///< copying the image to the staging file
+	fpgaDone,	  ///< loadFPGAFromFile() succeeded
+	fpgaFailed,	  ///< a read, write, CRC check or the load failed, see error()
+} FpgaLoadState;
+
+/**
+ * @brief why a load failed
+ */
+typedef enum _FpgaLoadError
+{
+	fpgaOk = 0,
+	fpgaReadError,
+	fpgaWriteError,
+	fpgaSizeError, ///< more or fewer bytes than announced
+	fpgaCrcError,
+	fpgaLoadError,	///< loadFPGAFromFile() returned failure
+	fpgaSpaceError, ///< preAllocateSpaceForFile() could not reserve the image size
+} FpgaLoadError;
+
+/**
+ * @brief signature of the progress callback, called when the whole percentage changes and once with
+ * FWWASM_FPGA_PROGRESS_FAILED if the load fails
+ */
+typedef void (*FpgaProgressFn)(void* context, int percent);
+
+/// @brief progress callback that drives a dialog opened with showDialogProgressBar(), completing it on failure too
+inline void fpgaProgressDialog(void*, int percent)
+{
+	setProgressDialogValue(percent == FWWASM_FPGA_PROGRESS_FAILED ? 100 : percent);
+}
+
+/**
+ * @brief counters kept by FpgaLoader
+ */
+struct FpgaLoadStats
+{
+	unsigned int bytes;		 ///< image bytes staged
+	unsigned int chunks;	 ///< chunks staged
+	unsigned int readCalls;	 ///< readFile() calls made for a file source
+	unsigned int writeCalls; ///< writeFile() calls made
+	unsigned int progress;	 ///< progress callbacks made
+	unsigned int loadMs;	 ///< time spent in loadFPGAFromFile()
+};
+
+/**
+ * @brief stages an FPGA image in chunks, verifies it and loads it.
+ * @tparam CHUNK bytes copied per step(), also the read buffer size for a file source
+ */
+template <size_t CHUNK = 4096>
+class FpgaLoader
+{
+public:
+	explicit FpgaLoader(FpgaIO io = defaultFpgaIO())
+		: m_io(io), m_state(fpgaIdle), m_error(fpgaOk), m_source(nullptr), m_sourceHandle(-1), m_stage(-1), m_size(0), m_done(0),
+		  m_crc(0), m_expectedCrc(0), m_checkCrc(false), m_percent(-1), m_progressFn(nullptr), m_context(nullptr)
+	{
+		m_name[0] = 0;
+		memset(&m_stats, 0, sizeof(m_stats));
+	}
+
+	/// @brief set the progress callback, nullptr for none
+	void onProgress(FpgaProgressFn fn, void* context)
+	{
+		m_progressFn = fn;
+		m_context = context;
+	}
+
+	/**
+	 * @brief stage an image held in WASM memory; the data must stay valid until the load finishes
+	 * @param data the bitstream
+	 * @param size the bitstream size
+	 * @param stageHandle an open, writable handle of the staging file; FpgaLoader closes it
+	 * @param stageName the name of the staging file, passed to loadFPGAFromFile()
+	 * @param expectedCrc the CRC-32 of the image, used only with checkCrc
+	 * @param checkCrc compare the image with expectedCrc before loading it
+	 * @return false if the arguments are invalid, or if the image size cannot be reserved (state() is then fpgaFailed)
+	 */
+	bool beginFromMemory(const unsigned char* data, size_t size, int stageHandle, const char* stageName, unsigned int expectedCrc = 0,
+		bool checkCrc = false)
+	{
+		if (!begin(size, stageHandle, stageName, expectedCrc, checkCrc))
+			return false;
+		m_source = data;
+		return true;
+	}
+
+	/**
+	 * @brief stage an image from another open file, for example one copied to the card under a different name
+	 * @param sourceHandle an open, readable handle positioned at the image; FpgaLoader does not close it
+	 * @see beginFromMemory() for the other parameters
+	 */
+	bool beginFromFile(int sourceHandle, size_t size, int stageHandle, const char* stageName, unsigned int expectedCrc = 0,
+		bool checkCrc = false)
+	{
+		if (sourceHandle < 0 || !begin(size, stageHandle, stageName, expectedCrc, checkCrc))
+			return false;
+		m_sourceHandle = sourceHandle;
+		return true;
+	}
+
+	/**
+	 * @brief stage an image the app feeds itself with write()
+	 * @see beginFromMemory() for the parameters
+	 */
+	bool beginStream(size_t size, int stageHandle, const char* stageName, unsigned int expectedCrc = 0, bool checkCrc = false)
+	{
+		return begin(size, stageHandle, stageName, expectedCrc, checkCrc);
+	}
+
+	/**
+	 * @brief add the next part of a streamed image; the load runs when the last byte arrives
+	 * @return false if the load failed
+	 */
+	bool write(const unsigned char* data, size_t length)
+	{
+		if (m_state != fpgaStaging)
+			return false;
+		if (length > m_size - m_done)
+			return fail(fpgaSizeError);
+		while (length && m_state == fpgaStaging)
+		{
+			size_t chunk = length < CHUNK ? length : CHUNK;
+			if (!stage(data, chunk))
+				return false;
+			data += chunk;
+			length -= chunk;
+		}
+		return m_state != fpgaFailed;
+	}
+
+	/**
+	 * @brief copy one chunk from a memory or file source, call every loop iteration while staging
+	 * @return the state after the step
+	 */
+	FpgaLoadState step()
+	{
+		if (m_state != fpgaStaging || (!m_source && m_sourceHandle < 0))
+			return m_state;
+		size_t chunk = m_size - m_done < CHUNK ? m_size - m_done : CHUNK;
+		if (m_source)
+		{
+			stage(m_source + m_done, chunk);
+			return m_state;
+		}
+		int bytes = static_cast<int>(chunk);
+		m_stats.readCalls++;
+		if (m_io.read(m_sourceHandle, m_buffer, &bytes) <= 0 || bytes <= 0)
+		{
+			fail(fpgaReadError);
+			return m_state;
+		}
+		stage(m_buffer, static_cast<size_t>(bytes));
+		return m_state;
+	}
+
+	/// @brief run step() until the load finishes, for callers that do not need the loop
+	FpgaLoadState run()
+	{
+		while (m_state == fpgaStaging && (m_source || m_sourceHandle >= 0))
+			step();
+		return m_state;
+	}
+
+	/// @brief abandon a load in progress and close the staging file
+	void cancel()
+	{
+		if (m_state == fpgaStaging)
+		{
+			closeStage();
+			m_state = fpgaIdle;
+		}
+	}
+
+	FpgaLoadState state() const { return m_state; }
+	FpgaLoadError error() const { return m_error; }
+
+	/// @brief CRC-32 of the bytes staged so far, the whole image once staging is complete
+	unsigned int crc() const { return m_crc; }
+
+	/// @brief progress in percent, staging covers 0-95 and loading the FPGA the rest
+	int percent() const { return m_percent < 0 ? 0 : m_percent; }
+
+	FpgaLoadStats stats() const { return m_stats; }
+
+private:
+	FpgaLoader(const FpgaLoader&);
+	FpgaLoader& operator=(const FpgaLoader&);
+
+	static const int kStagedPercent = 95;
+
+	bool begin(size_t size, int stageHandle, const char* stageName, unsigned int expectedCrc, bool checkCrc)
+	{
+		if (m_state == fpgaStaging || stageHandle < 0 || !size || strlen(stageName) >= sizeof(m_name))
+			return false;
+		strcpy(m_name, stageName);
+		m_stage = stageHandle;
+		m_source = nullptr;
+		m_sourceHandle = -1;
+		m_size = size;
+		m_done = 0;
+		m_crc = 0;
+		m_expectedCrc = expectedCrc;
+		m_checkCrc = checkCrc;
+		m_percent = -1;
+		m_error = fpgaOk;
+		m_state = fpgaStaging;
+		// reserve the whole image up front so the file does not grow chunk by chunk, and a full card fails before any copying
+		if (m_io.preAllocate(m_stage, static_cast<int>(size)) <= 0)
+			return fail(fpgaSpaceError);
+		report(0);
+		return true;
+	}
+
+	bool stage(const unsigned char* data, size_t length)
+	{
+		m_stats.writeCalls++;
+		// writeFile() does not modify the data
+		if (m_io.write(m_stage, const_cast<unsigned char*>(data), static_cast<int>(length)) <= 0)
+			return fail(fpgaWriteError);
+		m_crc = crc32Update(m_crc, data, length);
+		m_done += length;
+		m_stats.bytes += static_cast<unsigned int>(length);
+		m_stats.chunks++;
+		report(static_cast<int>(static_cast<unsigned long long>(m_done) * kStagedPercent / m_size));
+		if (m_done == m_size)
+			return finish();
+		return true;
+	}
+
+	bool finish()
+	{
+		closeStage();
+		if (m_checkCrc && m_crc != m_expectedCrc)
+			return fail(fpgaCrcError);
+		unsigned int start = millis();
+		int ok = m_io.load(m_name);
+		m_stats.loadMs += millis() - start;
+		if (ok <= 0)
+			return fail(fpgaLoadError);
+		m_state = fpgaDone;
+		report(100);
+		return true;
+	}
+
+	// Every failure ends here, so the staging file is closed and the progress callback learns the load is over.
+	bool fail(FpgaLoadError error)
+	{
+		closeStage();
+		m_state = fpgaFailed;
+		m_error = error;
+		if (m_progressFn)
+		{
+			m_stats.progress++;
+			m_progressFn(m_context, FWWASM_FPGA_PROGRESS_FAILED);
+		}
+		return false;
+	}
+
+	void closeStage()
+	{
+		if (m_stage < 0)
+			return;
+		m_io.close(m_stage);
+		m_stage = -1;
+	}
+
+	void report(int percent)
+	{
+		if (percent == m_percent)
+			return;
+		m_percent = percent;
+		if (m_progressFn)
+		{
+			m_stats.progress++;
+			m_progressFn(m_context, percent);
+		}
+	}
+
+	FpgaIO m_io;
+	FpgaLoadState m_state;
+	FpgaLoadError m_error;
+	const unsigned char* m_source;
+	int m_sourceHandle;
+	int m_stage;
+	size_t m_size;
+	size_t m_done;
+	unsigned int m_crc;
+	unsigned int m_expectedCrc;
+	bool m_checkCrc;
+	int m_percent;
+	FpgaProgressFn m_progressFn;
+	void* m_context;
+	FpgaLoadStats m_stats;
+	char m_name[64];
+	unsigned char m_buffer[CHUNK];
+};
+
+} // namespace fwwasm
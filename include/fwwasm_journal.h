@@ -0,0 +1,316 @@
+/**
+@file
+	@brief Free-Wili wasm crash-safe append-only journal
+Appends fixed-size, checksummed records to a file in extents reserved with preAllocateSpaceForFile(), so the file can
+stay open and be flushed rarely: after a power loss every record that fully reached the card is recovered and a torn
+record at the tail is detected and overwritten.
+
+Record layout (RECORD_SIZE bytes, little-endian):
+ - magic (2 bytes), payload length (2 bytes), sequence number (4 bytes)
+ - payload, zero padded to RECORD_SIZE - 12 bytes
+ - CRC-32 of the journal id, the header fields and the padded payload (4 bytes)
+
+Record 0 is a header holding the record size and the journal id. create() derives the id from the id of the journal the
+file held before, so records left in preallocated space by an older journal carry a different id and fail the
+checksum even when wilirand() and millis() repeat after a reboot.
+*/
+#pragma once
+
+#include "fwwasm.h"
+#include "fwwasm_file.h"
+
+#include <stddef.h>
+#include <string.h>
+
+namespace fwwasm
+{
+
+/**
+ * @brief file functions used by Journal, defaults to the Free-Wili imports and can be replaced by a host stand-in
+ */
+struct JournalIO
+{
+	FileWriteFn write;
+	int (*read)(int handle, unsigned char* data, int* data_bytes);
+	int (*setPosition)(int handle, int position);
+	int (*getSize)(int handle);
+	int (*preAllocate)(int handle, int size_in_bytes);
+};
+
+/// @brief JournalIO bound to writeFile(), readFile(), setFilePosition(), getFileSize() and preAllocateSpaceForFile()
+inline JournalIO defaultJournalIO()
+{
+	JournalIO io = { writeFile, readFile, setFilePosition, getFileSize, preAllocateSpaceForFile };
+	return io;
+}
+
+/**
+ * @brief counters kept by Journal
+ */
+struct JournalStats
+{
+	unsigned int appended;		 ///< records accepted by append()
+	unsigned int recovered;		 ///< valid records found by open()
+	unsigned int flushes;		 ///< flush() calls that wrote data
+	unsigned int writeCalls;	 ///< writeFile() calls made
+	unsigned int preallocations; ///< preAllocateSpaceForFile() calls made
+};
+
+/**
+ * @brief append-only journal of checksummed fixed-size records.
+ * @tparam RECORD_SIZE bytes per record including 12 bytes of framing, a divisor of 512 keeps records inside SD sectors
+ * @tparam BUFFER write buffer size in bytes, records reach the card when it fills or on flush()
+ *
+ * @code
+ * static fwwasm::Journal<64> journal;
+ * int handle = openFile("run.jnl", mode);
+ * if (!journal.open(handle, onRecord, nullptr)) // replays complete records from the last run
+ *     journal.create(handle);
+ * journal.append(&sample, sizeof(sample));
+ * ...
+ * if (millis() - lastFlush > 5000)
+ *     journal.flush();
+ * @endcode
+ */
+template <size_t RECORD_SIZE = 64, size_t BUFFER = 512>
+class Journal
+{
+	static_assert(RECORD_SIZE >= 16 && RECORD_SIZE <= 0xFFFF, "unsupported record size");
+
+public:
+	static const size_t kPayloadMax = RECORD_SIZE - 12;
+
+	/// @brief callback for each record found by open()
+	typedef void (*RecordFn)(void* context, unsigned int sequence, const unsigned char* payload, size_t length);
+
+	/**
+	 * @brief create a journal object
+	 * @param extentBytes bytes reserved with preAllocateSpaceForFile() each time the file grows, 0 to disable
+	 * @param io the file functions to use
+	 */
+	explicit Journal(unsigned int extentBytes = 64 * 1024, JournalIO io = defaultJournalIO())
+		: m_io(io), m_extent(extentBytes), m_handle(-1), m_id(0), m_sequence(0), m_offset(0), m_allocated(0), m_out(-1, io.write)
+	{
+		memset(&m_stats, 0, sizeof(m_stats));
+	}
+
+	/**
+	 * @brief start a new, empty journal in a file, replacing any journal it held
+	 * @param handle a handle returned by openFile()
+	 * @return true if the header record was written
+	 */
+	bool create(int handle)
+	{
+		m_handle = handle;
+		m_sequence = 0;
+		m_offset = 0;
+		m_allocated = 0;
+		if (!succeeded(m_io.setPosition(handle, 0)))
+			return false;
+		unsigned char record[RECORD_SIZE];
+		unsigned int previous;
+		// an odd step from the previous id cannot return to an earlier id of this file within 2^32 journals
+		if (readBlock(record, RECORD_SIZE) == RECORD_SIZE && validHeader(record, previous))
+			m_id = previous + 0x9E3779B9u;
+		else
+			m_id = static_cast<unsigned int>(wilirand()) ^ millis();
+		if (!succeeded(m_io.setPosition(handle, 0)))
+			return false;
+		m_out.setHandle(handle);
+		memset(record, 0, sizeof(record));
+		putU16(record, kHeaderMagic);
+		putU16(record + 2, RECORD_SIZE);
+		detail::putU32(record + 4, m_id);
+		detail::putU32(record + RECORD_SIZE - 4, crc32Update(0, record, RECORD_SIZE - 4));
+		if (!reserve())
+			return false;
+		m_out.write(record, RECORD_SIZE);
+		m_offset = RECORD_SIZE;
+		return flush();
+	}
+
+	/**
+	 * @brief recover an existing journal and position it for appending
+	 * @param handle a handle returned by openFile()
+	 * @param onRecord called for every complete record in order, may be nullptr
+	 * @param context passed to onRecord
+	 * @return false if the file has no valid journal header, call create() in that case
+	 */
+	bool open(int handle, RecordFn onRecord = nullptr, void* context = nullptr)
+	{
+		m_handle = handle;
+		int size = m_io.getSize(handle);
+		if (size < static_cast<int>(RECORD_SIZE) || !succeeded(m_io.setPosition(handle, 0)))
+			return false;
+		unsigned char block[RECORD_SIZE * 8];
+		size_t have = readBlock(block, sizeof(block));
+		if (have < RECORD_SIZE || !validHeader(block, m_id))
+			return false;
+		m_sequence = 0;
+		m_stats.recovered = 0;
+		unsigned int offset = RECORD_SIZE;
+		size_t pos = RECORD_SIZE;
+		bool done = false;
+		while (!done)
+		{
+			for (; pos + RECORD_SIZE <= have; pos += RECORD_SIZE)
+			{
+				const unsigned char* record = block + pos;
+				if (!validRecord(record, m_sequence))
+				{
+					done = true;
+					break;
+				}
+				if (onRecord)
+					onRecord(context, m_sequence, record + 8, getU16(record + 2));
+				m_sequence++;
+				m_stats.recovered++;
+				offset += RECORD_SIZE;
+			}
+			if (done || offset + RECORD_SIZE > static_cast<unsigned int>(size))
+				break;
+			have = readBlock(block, sizeof(block));
+			pos = 0;
+			if (have < RECORD_SIZE)
+				break;
+		}
+		m_offset = offset;
+		m_allocated = static_cast<unsigned int>(size);
+		if (!succeeded(m_io.setPosition(handle, static_cast<int>(offset))))
+			return false;
+		m_out.setHandle(handle);
+		return true;
+	}
+
+	/**
+	 * @brief append a record
+	 * @param data the payload
+	 * @param length the payload size, at most kPayloadMax bytes
+	 * @return false if the payload is too large or a write failed
+	 */
+	bool append(const void* data, size_t length)
+	{
+		if (m_handle < 0 || length > kPayloadMax)
+			return false;
+		if (m_offset + RECORD_SIZE > m_allocated && !reserve())
+			return false;
+		unsigned char record[RECORD_SIZE];
+		memset(record, 0, sizeof(record));
+		putU16(record, kRecordMagic);
+		putU16(record + 2, static_cast<unsigned int>(length));
+		detail::putU32(record + 4, m_sequence);
+		memcpy(record + 8, data, length);
+		detail::putU32(record + RECORD_SIZE - 4, recordCrc(record));
+		m_sequence++;
+		m_offset += RECORD_SIZE;
+		m_stats.appended++;
+		return m_out.write(record, RECORD_SIZE);
+	}
+
+	/**
+	 * @brief push buffered records to the card; records appended before a successful flush survive power loss
+	 */
+	bool flush()
+	{
+		if (!m_out.pending())
+			return true;
+		m_stats.flushes++;
+		return m_out.flush();
+	}
+
+	/// @brief number of records in the journal
+	unsigned int count() const { return m_sequence; }
+
+	/// @brief number of records that would be lost if power failed now
+	size_t unflushed() const { return m_out.pending() / RECORD_SIZE; }
+
+	JournalStats stats() const
+	{
+		JournalStats s = m_stats;
+		s.writeCalls = m_out.stats().writeCalls;
+		return s;
+	}
+
+private:
+	Journal(const Journal&);
+	Journal& operator=(const Journal&);
+
+	enum
+	{
+		kHeaderMagic = 0x484A, // "JH"
+		kRecordMagic = 0x524A, // "JR"
+	};
+
+	// see the return value note in fwwasm_file.h
+	static bool succeeded(int result) { return result > 0; }
+
+	static void putU16(unsigned char* out, unsigned int value)
+	{
+		out[0] = static_cast<unsigned char>(value);
+		out[1] = static_cast<unsigned char>(value >> 8);
+	}
+
+	static unsigned int getU16(const unsigned char* in)
+	{
+		return static_cast<unsigned int>(in[0]) | (static_cast<unsigned int>(in[1]) << 8);
+	}
+
+	unsigned int recordCrc(const unsigned char* record) const
+	{
+		unsigned char id[4];
+		detail::putU32(id, m_id);
+		return crc32Update(crc32Update(0, id, 4), record, RECORD_SIZE - 4);
+	}
+
+	static bool validHeader(const unsigned char* record, unsigned int& id)
+	{
+		if (getU16(record) != kHeaderMagic || getU16(record + 2) != RECORD_SIZE ||
+			detail::getU32(record + RECORD_SIZE - 4) != crc32Update(0, record, RECORD_SIZE - 4))
+			return false;
+		id = detail::getU32(record + 4);
+		return true;
+	}
+
+	bool validRecord(const unsigned char* record, unsigned int sequence) const
+	{
+		return getU16(record) == kRecordMagic && getU16(record + 2) <= kPayloadMax && detail::getU32(record + 4) == sequence &&
+			detail::getU32(record + RECORD_SIZE - 4) == recordCrc(record);
+	}
+
+	size_t readBlock(unsigned char* block, size_t size)
+	{
+		int bytes = static_cast<int>(size);
+		if (!succeeded(m_io.read(m_handle, block, &bytes)) || bytes < 0)
+			return 0;
+		return static_cast<size_t>(bytes) - static_cast<size_t>(bytes) % RECORD_SIZE;
+	}
+
+	// Grow the reserved space by one extent so appends do not extend the file (and its FAT chain) record by record.
+	bool reserve()
+	{
+		if (!m_extent)
+		{
+			m_allocated = 0xFFFFFFFF;
+			return true;
+		}
+		unsigned int target = m_offset + m_extent;
+		target -= target % static_cast<unsigned int>(RECORD_SIZE);
+		m_stats.preallocations++;
+		if (!succeeded(m_io.preAllocate(m_handle, static_cast<int>(target))))
+			return false;
+		m_allocated = target;
+		return true;
+	}
+
+	JournalIO m_io;
+	unsigned int m_extent;
+	int m_handle;
+	unsigned int m_id;
+	unsigned int m_sequence;
+	unsigned int m_offset;
+	unsigned int m_allocated;
+	JournalStats m_stats;
+	BufferedFileWriter<BUFFER> m_out;
+};
+
+} // namespace fwwasm
@@ -0,0 +1,253 @@
+/**
+@file
+	@brief Free-Wili wasm board LED animation
+Plays multi-LED keyframe animations from a compact constant table without blocking the main loop. update() is called
+every loop iteration with millis(); it advances at a fixed frame interval and calls setBoardLED() only for LEDs whose
+color actually changed, or whose hold is about to run out in a looping animation, so holds and slow fades cost almost
+no host crossings and nothing waits in waitms().
+
+@code
+static const fwwasm::LedKeyframe kAlarm[] = {
+	// time ms, led, r, g, b, ease
+	{ 0, 0, 255, 0, 0, fwwasm::ledStep },
+	{ 0, 1, 0, 0, 0, fwwasm::ledLinear },
+	{ 250, 1, 255, 0, 0, fwwasm::ledStep },
+	{ 500, 0, 0, 0, 0, fwwasm::ledStep },
+};
+static fwwasm::LedPlayer<> leds;
+leds.play(kAlarm, 4, 600, true, millis());
+while (1)
+	leds.update(millis());
+@endcode
+*/
+#pragma once
+
+#include "fwwasm.h"
+
+#include <stddef.h>
+#include <string.h>
+
+namespace fwwasm
+{
+
+/**
+ * @brief how a LED reaches the color of its next keyframe
+ */
+typedef enum _LedEase
+{
+	ledStep = 0, ///< hold this keyframe's color until the next keyframe
+	ledLinear,	 ///< fade linearly from this keyframe's color to the next keyframe's color
+} LedEase;
+
+/**
+ * @brief one keyframe, tables must be sorted by timeMs
+ */
+struct LedKeyframe
+{
+	unsigned short timeMs; ///< time from the start of the animation
+	unsigned char led;	   ///< led_index passed to setBoardLED()
+	unsigned char r;
+	unsigned char g;
+	unsigned char b;
+	unsigned char ease; ///< see LedEase
+};
+
+/**
+ * @brief signature of the LED output function, matches setBoardLED()
+ */
+typedef void (*BoardLEDFn)(int led_index, int red, int green, int blue, int duration_ms, LEDManagerLEDMode mode);
+
+/**
+ * @brief counters kept by LedPlayer
+ */
+struct LedPlayerStats
+{
+	unsigned int frames; ///< animation frames evaluated
+	unsigned int calls;	 ///< setBoardLED() calls made
+	unsigned int loops;	 ///< times a looping animation wrapped
+};
+
+/**
+ * @brief non-blocking keyframe player for the board LEDs.
+ * @tparam LED_COUNT the number of LEDs the player tracks, keyframes for higher indexes are ignored
+ */
+template <size_t LED_COUNT = 7>
+class LedPlayer
+{
+public:
+	/// @brief callback run once when a non-looping animation finishes
+	typedef void (*CompleteFn)(void* context);
+
+	/**
+	 * @brief create a player
+	 * @param frameIntervalMs the minimum time between evaluated frames
+	 * @param ledFn the output function, setBoardLED() unless a host stand-in is substituted
+	 */
+	explicit LedPlayer(unsigned int frameIntervalMs = 20, BoardLEDFn ledFn = setBoardLED)
+		: m_ledFn(ledFn), m_frameInterval(frameIntervalMs), m_keys(nullptr), m_count(0), m_length(0), m_loop(false), m_playing(false),
+		  m_start(0), m_lastFrame(0), m_onComplete(nullptr), m_context(nullptr)
+	{
+		memset(&m_stats, 0, sizeof(m_stats));
+		for (size_t i = 0; i < LED_COUNT; i++)
+		{
+			m_shown[i] = kUnknown;
+			m_expires[i] = 0;
+		}
+	}
+
+	/**
+	 * @brief start an animation; the table is not copied and must outlive playback
+	 * @param keys keyframes sorted by time
+	 * @param count the number of keyframes
+	 * @param lengthMs the animation length, the loop period when looping
+	 * @param loop restart at the end instead of finishing
+	 * @param nowMs the current time, typically millis()
+	 */
+	void play(const LedKeyframe* keys, size_t count, unsigned int lengthMs, bool loop, unsigned int nowMs)
+	{
+		m_keys = keys;
+		m_count = count;
+		m_length = lengthMs ? lengthMs : 1;
+		m_loop = loop;
+		m_playing = count != 0;
+		m_start = nowMs;
+		m_lastFrame = nowMs - m_frameInterval;
+		// holds sent for the previous animation do not cover this one
+		resync();
+		update(nowMs);
+	}
+
+	/// @brief run a callback when a non-looping animation ends, the app side equivalent of FWGUI_EVENT_LIGHT_SHOW
+	void onComplete(CompleteFn fn, void* context)
+	{
+		m_onComplete = fn;
+		m_context = context;
+	}
+
+	/// @brief stop playback; each LED keeps its last color only until the hold sent with it runs out
+	void stop() { m_playing = false; }
+
+	bool playing() const { return m_playing; }
+
+	/**
+	 * @brief advance the animation, call every loop iteration
+	 * @param nowMs the current time, typically millis()
+	 * @return the number of setBoardLED() calls made
+	 */
+	unsigned int update(unsigned int nowMs)
+	{
+		if (!m_playing || nowMs - m_lastFrame < m_frameInterval)
+			return 0;
+		m_lastFrame = nowMs;
+		unsigned int t = nowMs - m_start;
+		bool finished = false;
+		if (t >= m_length)
+		{
+			if (m_loop)
+			{
+				m_stats.loops += t / m_length;
+				m_start += t - t % m_length;
+				t %= m_length;
+			}
+			else
+			{
+				t = m_length;
+				finished = true;
+			}
+		}
+		m_stats.frames++;
+		unsigned int calls = render(t, nowMs);
+		if (finished)
+		{
+			m_playing = false;
+			if (m_onComplete)
+				m_onComplete(m_context);
+		}
+		return calls;
+	}
+
+	/// @brief forget the colors last sent so the next frame rewrites every animated LED
+	void resync()
+	{
+		for (size_t i = 0; i < LED_COUNT; i++)
+			m_shown[i] = kUnknown;
+	}
+
+	LedPlayerStats stats() const { return m_stats; }
+
+private:
+	static const unsigned int kUnknown = 0xFFFFFFFF;
+
+	unsigned int render(unsigned int t, unsigned int nowMs)
+	{
+		// per LED: the last keyframe at or before t and the first one after it
+		int prev[LED_COUNT];
+		int next[LED_COUNT];
+		for (size_t i = 0; i < LED_COUNT; i++)
+			prev[i] = next[i] = -1;
+		for (size_t k = 0; k < m_count; k++)
+		{
+			const LedKeyframe& key = m_keys[k];
+			if (key.led >= LED_COUNT)
+				continue;
+			if (key.timeMs <= t)
+				prev[key.led] = static_cast<int>(k);
+			else if (next[key.led] < 0)
+				next[key.led] = static_cast<int>(k);
+		}
+		unsigned int calls = 0;
+		for (size_t led = 0; led < LED_COUNT; led++)
+		{
+			if (prev[led] < 0)
+				continue;
+			const LedKeyframe& a = m_keys[prev[led]];
+			unsigned int r = a.r, g = a.g, b = a.b;
+			if (a.ease == ledLinear && next[led] >= 0)
+			{
+				const LedKeyframe& z = m_keys[next[led]];
+				unsigned int span = z.timeMs - a.timeMs;
+				unsigned int pos = t - a.timeMs;
+				r = lerp(a.r, z.r, pos, span);
+				g = lerp(a.g, z.g, pos, span);
+				b = lerp(a.b, z.b, pos, span);
+			}
+			unsigned int rgb = r << 16 | g << 8 | b;
+			// a looping animation has no end to hold until, so a steady LED is renewed before its hold runs out
+			bool expiring = m_loop && static_cast<int>(m_expires[led] - nowMs) <= static_cast<int>(2 * m_frameInterval);
+			if (rgb == m_shown[led] && !expiring)
+				continue;
+			m_shown[led] = rgb;
+			// hold for the rest of the animation, or one period when looping; later frames overwrite it
+			int hold = static_cast<int>(m_loop ? m_length + 2 * m_frameInterval : m_length - t + m_frameInterval);
+			m_expires[led] = nowMs + static_cast<unsigned int>(hold);
+			m_ledFn(static_cast<int>(led), static_cast<int>(r), static_cast<int>(g), static_cast<int>(b), hold, ledsimplevalue);
+			calls++;
+		}
+		m_stats.calls += calls;
+		return calls;
+	}
+
+	static unsigned int lerp(unsigned int from, unsigned int to, unsigned int pos, unsigned int span)
+	{
+		if (!span || pos >= span)
+			return to;
+		return to >= from ? from + (to - from) * pos / span : from - (from - to) * pos / span;
+	}
+
+	BoardLEDFn m_ledFn;
+	unsigned int m_frameInterval;
+	const LedKeyframe* m_keys;
+	size_t m_count;
+	unsigned int m_length;
+	bool m_loop;
+	bool m_playing;
+	unsigned int m_start;
+	unsigned int m_lastFrame;
+	CompleteFn m_onComplete;
+	void* m_context;
+	unsigned int m_shown[LED_COUNT];
+	unsigned int m_expires[LED_COUNT];
+	LedPlayerStats m_stats;
+};
+
+} // namespace fwwasm
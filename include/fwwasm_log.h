@@ -0,0 +1,250 @@
+/**
+@file
+	@brief Free-Wili wasm log control feeder
+Queues text lines for an addControlLogList() control in a bounded ring and hands them to setLogDataText() at a fixed
+number of lines per frame, so bursts of input do not overrun the GUI. Consecutive duplicate lines are coalesced into
+one line with a repeat count and every line can optionally be mirrored to a file through a BufferedFileWriter.
+*/
+#pragma once
+
+#include "fwwasm.h"
+#include "fwwasm_file.h"
+#include "fwwasm_format.h"
+
+#include <stddef.h>
+#include <string.h>
+
+namespace fwwasm
+{
+
+/**
+ * @brief what LogFeeder does when a line arrives and the ring is full
+ */
+typedef enum _LogFeederOverflow
+{
+	logDropOldest = 0, ///< discard the oldest queued line to make room
+	logDropNewest,	   ///< discard the incoming line
+} LogFeederOverflow;
+
+/**
+ * @brief counters kept by LogFeeder, used to size the ring and the per frame rate
+ */
+struct LogFeederStats
+{
+	unsigned int pushed;	///< lines passed to push()
+	unsigned int emitted;	///< setLogDataText() calls made
+	unsigned int dropped;	///< lines lost because the ring was full
+	unsigned int coalesced; ///< lines folded into the previous line's repeat count
+	unsigned int truncated; ///< lines cut to fit the line length
+	unsigned int highWater; ///< most lines queued at once
+};
+
+/**
+ * @brief signature of the function that shows a line, matches setLogDataText()
+ */
+typedef void (*LogTextFn)(int log, const char* text);
+
+/**
+ * @brief bounded, rate limited feeder for setLogDataText().
+ * @tparam LINES the number of lines the ring can hold
+ * @tparam LINE_LEN the maximum line length including the terminator
+ *
+ * @code
+ * static fwwasm::LogFeeder<32> feeder(0, 4);
+ * feeder.push("connected");
+ * feeder.pushf("rx {} bytes", count);
+ * while (1)
+ * {
+ *     ...
+ *     feeder.pump(); // at most 4 setLogDataText() calls
+ * }
+ * @endcode
+ */
+template <size_t LINES, size_t LINE_LEN = 64>
+class LogFeeder
+{
+public:
+	/**
+	 * @brief create a feeder
+	 * @param log the index of the log passed to setLogDataText()
+	 * @param linesPerFrame the most lines pump() emits per call, 0 for no limit
+	 * @param overflow the policy when the ring is full
+	 * @param logFn the output function, setLogDataText() unless a host stand-in is substituted
+	 */
+	explicit LogFeeder(int log,
+		unsigned int linesPerFrame = 4,
+		LogFeederOverflow overflow = logDropOldest,
+		LogTextFn logFn = setLogDataText)
+		: m_log(log), m_linesPerFrame(linesPerFrame), m_overflow(overflow), m_logFn(logFn), m_head(0), m_count(0), m_mirror(nullptr),
+		  m_mirrorFn(nullptr)
+	{
+		memset(&m_stats, 0, sizeof(m_stats));
+	}
+
+	/// @brief change the number of lines pump() may emit per call, 0 for no limit
+	void setLinesPerFrame(unsigned int linesPerFrame) { m_linesPerFrame = linesPerFrame; }
+
+	/**
+	 * @brief copy every pushed line (including duplicates and lines later dropped) to a file
+	 * @param writer the buffered writer for the mirror file, nullptr to stop mirroring
+	 */
+	template <size_t SIZE>
+	void setMirror(BufferedFileWriter<SIZE>* writer)
+	{
+		m_mirror = writer;
+		m_mirrorFn = writer ? &mirrorThunk<SIZE> : nullptr;
+	}
+
+	/**
+	 * @brief queue a line
+	 * @param szText the line, longer lines are truncated to LINE_LEN - 1 characters
+	 * @return false if the line (or the oldest queued line) was dropped
+	 */
+	bool push(const char* szText)
+	{
+		m_stats.pushed++;
+		size_t len = strlen(szText);
+		if (m_mirrorFn)
+			m_mirrorFn(m_mirror, szText, len);
+		if (len > LINE_LEN - 1)
+		{
+			len = LINE_LEN - 1;
+			m_stats.truncated++;
+		}
+		if (m_count)
+		{
+			Line& last = m_lines[(m_head + m_count - 1) % LINES];
+			if (last.length == len && memcmp(last.text, szText, len) == 0 && last.repeat < 0xFFFF)
+			{
+				last.repeat++;
+				m_stats.coalesced++;
+				return true;
+			}
+		}
+		bool ok = true;
+		if (m_count == LINES)
+		{
+			m_stats.dropped++;
+			ok = false;
+			if (m_overflow == logDropNewest)
+				return false;
+			m_head = (m_head + 1) % LINES;
+			m_count--;
+		}
+		Line& line = m_lines[(m_head + m_count) % LINES];
+		memcpy(line.text, szText, len);
+		line.text[len] = 0;
+		line.length = static_cast<unsigned short>(len);
+		line.repeat = 1;
+		if (++m_count > m_stats.highWater)
+			m_stats.highWater = static_cast<unsigned int>(m_count);
+		return ok;
+	}
+
+	/**
+	 * @brief format and queue a line, see fwwasm_format.h for the placeholder syntax
+	 * @return false if a line was dropped
+	 */
+	template <typename... Args>
+	bool pushf(FormatString<typename detail::Identity<Args>::type...> fmt, const Args&... args)
+	{
+		FixedString<LINE_LEN> line;
+		formatTo<Args...>(line, fmt, args...);
+		if (line.truncated())
+			m_stats.truncated++;
+		return push(line.c_str());
+	}
+
+	/**
+	 * @brief emit queued lines, call once per loop iteration
+	 * @return the number of setLogDataText() calls made
+	 */
+	unsigned int pump()
+	{
+		unsigned int sent = 0;
+		while (m_count && (m_linesPerFrame == 0 || sent < m_linesPerFrame))
+		{
+			emit(m_lines[m_head]);
+			m_head = (m_head + 1) % LINES;
+			m_count--;
+			sent++;
+		}
+		return sent;
+	}
+
+	/// @brief emit everything queued regardless of the per frame limit
+	unsigned int flush()
+	{
+		unsigned int limit = m_linesPerFrame;
+		m_linesPerFrame = 0;
+		unsigned int sent = pump();
+		m_linesPerFrame = limit;
+		return sent;
+	}
+
+	/// @brief discard queued lines without emitting them
+	void clear()
+	{
+		m_head = 0;
+		m_count = 0;
+	}
+
+	/// @brief number of lines waiting to be emitted
+	size_t pending() const { return m_count; }
+
+	LogFeederStats stats() const { return m_stats; }
+
+	/// @brief reset the counters, the high-water mark restarts at the current queue depth
+	void clearStats()
+	{
+		memset(&m_stats, 0, sizeof(m_stats));
+		m_stats.highWater = static_cast<unsigned int>(m_count);
+	}
+
+private:
+	LogFeeder(const LogFeeder&);
+	LogFeeder& operator=(const LogFeeder&);
+
+	struct Line
+	{
+		unsigned short length;
+		unsigned short repeat;
+		char text[LINE_LEN];
+	};
+
+	typedef void (*MirrorFn)(void* writer, const char* text, size_t length);
+
+	template <size_t SIZE>
+	static void mirrorThunk(void* writer, const char* text, size_t length)
+	{
+		BufferedFileWriter<SIZE>* w = static_cast<BufferedFileWriter<SIZE>*>(writer);
+		w->write(text, length);
+		w->write("\n", 1);
+	}
+
+	void emit(const Line& line)
+	{
+		m_stats.emitted++;
+		if (line.repeat == 1)
+		{
+			m_logFn(m_log, line.text);
+			return;
+		}
+		FixedString<LINE_LEN + 12> text;
+		formatTo(text, "{} (x{})", line.text, line.repeat);
+		m_logFn(m_log, text.c_str());
+	}
+
+	int m_log;
+	unsigned int m_linesPerFrame;
+	LogFeederOverflow m_overflow;
+	LogTextFn m_logFn;
+	size_t m_head;
+	size_t m_count;
+	void* m_mirror;
+	MirrorFn m_mirrorFn;
+	LogFeederStats m_stats;
+	Line m_lines[LINES];
+};
+
+} // namespace fwwasm
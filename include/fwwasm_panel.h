@@ -0,0 +1,321 @@
+/**
+@file
+	@brief Free-Wili wasm batched panel updates
+Collects setControlValue(), setControlValueFloat(), setControlValueText() and setControlProperty() updates for one panel
+between begin() and commit(). Repeated updates of the same control and property inside a transaction collapse into the
+last one, and updates that would set the value the control already shows are skipped, so a dashboard refresh sends each
+changed control once, back to back, in a single commit. A control has one value however it is set: an integer, float or
+text update replaces a queued update of either other kind, and skipping compares against whichever was committed last,
+text byte for byte.
+*/
+#pragma once
+
+#include "fwwasm.h"
+
+#include <stddef.h>
+#include <string.h>
+
+namespace fwwasm
+{
+
+/**
+ * @brief control update functions used by PanelBatch, defaults to the Free-Wili imports and can be replaced by a host stand-in
+ */
+struct PanelSink
+{
+	void (*setValue)(int panel, int control, int value);
+	void (*setValueFloat)(int panel, int control, float value);
+	void (*setValueText)(int panel, int control, const char* text);
+	void (*setProperty)(int panel, int control, controlProperty property, int value);
+};
+
+/// @brief PanelSink bound to setControlValue(), setControlValueFloat(), setControlValueText() and setControlProperty()
+inline PanelSink defaultPanelSink()
+{
+	PanelSink sink = { setControlValue, setControlValueFloat, setControlValueText, setControlProperty };
+	return sink;
+}
+
+/**
+ * @brief counters kept by PanelBatch
+ */
+struct PanelBatchStats
+{
+	unsigned int queued;	///< update calls made on the batch
+	unsigned int coalesced; ///< updates replaced by a later update of the same control value or property
+	unsigned int skipped;	///< updates dropped because the control already shows the value
+	unsigned int applied;	///< host calls made by commit()
+	unsigned int commits;	///< commit() calls that applied at least one update
+	unsigned int overflows; ///< early commits forced by a full batch
+};
+
+/**
+ * @brief transaction style update buffer for one panel.
+ * @tparam MAX_UPDATES updates held per transaction
+ * @tparam TEXT_BYTES storage for text values per transaction
+ * @tparam SHADOW_ENTRIES remembered control values used to skip unchanged updates
+ * @tparam SHADOW_TEXT longest remembered text including the terminator, longer texts are always sent
+ *
+ * @code
+ * static fwwasm::PanelBatch<> dash(PANEL_DASH);
+ * dash.begin();
+ * dash.setValue(CTRL_RPM, rpm);
+ * dash.setValueFloat(CTRL_VOLTS, volts);
+ * dash.setProperty(CTRL_WARN, fwControlPropertyVisible, warn);
+ * dash.commit();
+ * @endcode
+ */
+template <size_t MAX_UPDATES = 64, size_t TEXT_BYTES = 1024, size_t SHADOW_ENTRIES = 128, size_t SHADOW_TEXT = 24>
+class PanelBatch
+{
+	static_assert(TEXT_BYTES <= 0xFFFF, "text offsets are 16 bit");
+
+public:
+	/**
+	 * @brief create a batch for one panel
+	 * @param panel the index of the panel
+	 * @param sink the functions commit() calls
+	 */
+	explicit PanelBatch(int panel, PanelSink sink = defaultPanelSink())
+		: m_panel(panel), m_sink(sink), m_count(0), m_textUsed(0), m_shadowCount(0)
+	{
+		memset(&m_stats, 0, sizeof(m_stats));
+	}
+
+	/// @brief start a transaction, discarding anything queued and not committed
+	void begin()
+	{
+		m_count = 0;
+		m_textUsed = 0;
+	}
+
+	/// @brief queue setControlValue()
+	void setValue(int control, int value) { queue(opValue, control, 0, static_cast<unsigned int>(value), nullptr); }
+
+	/// @brief queue setControlValueFloat()
+	void setValueFloat(int control, float value)
+	{
+		unsigned int bits;
+		memcpy(&bits, &value, sizeof(bits));
+		queue(opFloat, control, 0, bits, nullptr);
+	}
+
+	/// @brief queue setControlValueText(), the text is copied
+	void setValueText(int control, const char* text) { queue(opText, control, 0, 0, text); }
+
+	/// @brief queue setControlProperty()
+	void setProperty(int control, controlProperty property, int value)
+	{
+		queue(opProperty, control, static_cast<unsigned int>(property), static_cast<unsigned int>(value), nullptr);
+	}
+
+	/**
+	 * @brief apply every queued update in queue order
+	 * @return the number of host calls made
+	 */
+	unsigned int commit()
+	{
+		unsigned int calls = 0;
+		for (size_t i = 0; i < m_count; i++)
+		{
+			const Update& u = m_updates[i];
+			// a coalesced update may have returned to the value already shown
+			Shadow* s = findShadow(u.control, keyOf(u.op, u.property));
+			if (s && shows(*s, u.op, u.value, u.op == opText ? m_text + u.textOffset : nullptr))
+			{
+				m_stats.skipped++;
+				continue;
+			}
+			switch (u.op)
+			{
+				case opValue:
+					m_sink.setValue(m_panel, u.control, static_cast<int>(u.value));
+					break;
+				case opFloat:
+				{
+					float f;
+					memcpy(&f, &u.value, sizeof(f));
+					m_sink.setValueFloat(m_panel, u.control, f);
+					break;
+				}
+				case opText:
+					m_sink.setValueText(m_panel, u.control, m_text + u.textOffset);
+					break;
+				default:
+					m_sink.setProperty(m_panel, u.control, static_cast<controlProperty>(u.property), static_cast<int>(u.value));
+					break;
+			}
+			remember(u);
+			calls++;
+		}
+		if (calls)
+			m_stats.commits++;
+		m_stats.applied += calls;
+		m_count = 0;
+		m_textUsed = 0;
+		return calls;
+	}
+
+	/// @brief forget the remembered control values, call after the panel is rebuilt or changed elsewhere
+	void invalidate() { m_shadowCount = 0; }
+
+	/// @brief number of updates waiting for commit()
+	size_t pending() const { return m_count; }
+
+	PanelBatchStats stats() const { return m_stats; }
+
+private:
+	enum
+	{
+		opValue = 0,
+		opFloat,
+		opText,
+		opProperty,
+		opNone = 0xFF, ///< a shadow entry that matches nothing, e.g. a text too long to remember
+	};
+
+	struct Update
+	{
+		unsigned char op;
+		unsigned char property;
+		unsigned short textOffset;
+		int control;
+		unsigned int value; ///< value, float bits or property value
+	};
+
+	struct Shadow
+	{
+		int control;
+		unsigned short key; ///< see keyOf()
+		unsigned char op;	///< the op last committed for the key
+		unsigned int value;
+		char text[SHADOW_TEXT];
+	};
+
+	// setValue, setValueFloat and setValueText all set the one value of a control and share a key; properties each have their own
+	static unsigned short keyOf(unsigned int op, unsigned int property)
+	{
+		return static_cast<unsigned short>(op == opProperty ? 0x100 | property : 0);
+	}
+
+	static bool shows(const Shadow& s, unsigned int op, unsigned int value, const char* text)
+	{
+		if (s.op != op)
+			return false;
+		return op == opText ? strcmp(s.text, text) == 0 : s.value == value;
+	}
+
+	Shadow* findShadow(int control, unsigned short key)
+	{
+		for (size_t i = 0; i < m_shadowCount; i++)
+			if (m_shadow[i].control == control && m_shadow[i].key == key)
+				return &m_shadow[i];
+		return nullptr;
+	}
+
+	void remember(const Update& u)
+	{
+		unsigned short key = keyOf(u.op, u.property);
+		Shadow* s = findShadow(u.control, key);
+		if (!s)
+		{
+			if (m_shadowCount == SHADOW_ENTRIES)
+				return;
+			s = &m_shadow[m_shadowCount++];
+			s->control = u.control;
+			s->key = key;
+		}
+		s->op = u.op;
+		s->value = u.value;
+		if (u.op == opText)
+		{
+			size_t len = strlen(m_text + u.textOffset) + 1;
+			if (len <= SHADOW_TEXT)
+				memcpy(s->text, m_text + u.textOffset, len);
+			else
+				s->op = opNone;
+		}
+	}
+
+	// Removes a queued update, and its text from m_text so the bytes can be reused in this transaction.
+	void erase(Update* u)
+	{
+		if (u->op == opText)
+		{
+			size_t offset = u->textOffset;
+			size_t len = strlen(m_text + offset) + 1;
+			memmove(m_text + offset, m_text + offset + len, m_textUsed - offset - len);
+			m_textUsed -= len;
+			for (size_t i = 0; i < m_count; i++)
+				if (m_updates[i].op == opText && m_updates[i].textOffset > offset)
+					m_updates[i].textOffset = static_cast<unsigned short>(m_updates[i].textOffset - len);
+		}
+		size_t index = static_cast<size_t>(u - m_updates);
+		memmove(m_updates + index, m_updates + index + 1, (m_count - index - 1) * sizeof(Update));
+		m_count--;
+	}
+
+	void queue(unsigned int op, int control, unsigned int property, unsigned int value, const char* text)
+	{
+		m_stats.queued++;
+		unsigned short key = keyOf(op, property);
+		Update* existing = nullptr;
+		for (size_t i = 0; i < m_count; i++)
+			if (m_updates[i].control == control && keyOf(m_updates[i].op, m_updates[i].property) == key)
+				existing = &m_updates[i];
+		if (existing && existing->op == opText)
+		{
+			// replaced text is dropped rather than left in m_text, the new value is queued at the end
+			m_stats.coalesced++;
+			erase(existing);
+			existing = nullptr;
+		}
+		if (!existing)
+		{
+			Shadow* s = findShadow(control, key);
+			if (s && shows(*s, op, value, text))
+			{
+				m_stats.skipped++;
+				return;
+			}
+		}
+		size_t textLen = text ? strlen(text) + 1 : 0;
+		if ((!existing && m_count == MAX_UPDATES) || TEXT_BYTES - m_textUsed < textLen)
+		{
+			// out of room: apply what is queued so far and continue in a fresh batch
+			m_stats.overflows++;
+			commit();
+			existing = nullptr;
+			if (textLen > TEXT_BYTES)
+				return;
+		}
+		Update* u = existing;
+		if (u)
+			m_stats.coalesced++;
+		else
+			u = &m_updates[m_count++];
+		u->op = static_cast<unsigned char>(op);
+		u->property = static_cast<unsigned char>(property);
+		u->control = control;
+		u->value = value;
+		u->textOffset = 0;
+		if (text)
+		{
+			u->textOffset = static_cast<unsigned short>(m_textUsed);
+			memcpy(m_text + m_textUsed, text, textLen);
+			m_textUsed += textLen;
+		}
+	}
+
+	int m_panel;
+	PanelSink m_sink;
+	size_t m_count;
+	size_t m_textUsed;
+	size_t m_shadowCount;
+	PanelBatchStats m_stats;
+	Update m_updates[MAX_UPDATES];
+	char m_text[TEXT_BYTES];
+	Shadow m_shadow[SHADOW_ENTRIES];
+};
+
+} // namespace fwwasm
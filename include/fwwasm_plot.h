@@ -0,0 +1,233 @@
+/**
+@file
+	@brief Free-Wili wasm plot decimation
+PlotFeeder reduces a high-rate sample stream (ADC, audio, accelerometer) to what an addControlPlot() control can show:
+the samples that fall on one horizontal pixel are folded into a min/max envelope and only those two values are sent
+with setPlotData(), so spikes stay visible and the number of host crossings is bounded by the plot width rather than
+the sample rate. The per-pixel reduction uses WASM SIMD128 when the module is built with -msimd128.
+*/
+#pragma once
+
+#include "fwwasm.h"
+
+#include <stddef.h>
+#include <string.h>
+
+#if defined(__wasm_simd128__)
+#include <wasm_simd128.h>
+#endif
+
+namespace fwwasm
+{
+
+/**
+ * @brief find the minimum and maximum of a block of samples
+ * @param samples the samples
+ * @param count the number of samples, at least 1
+ * @param minOut receives the minimum
+ * @param maxOut receives the maximum
+ */
+inline void minMax(const int* samples, size_t count, int& minOut, int& maxOut)
+{
+	size_t i = 0;
+	int lo = samples[0];
+	int hi = samples[0];
+#if defined(__wasm_simd128__)
+	if (count >= 8)
+	{
+		v128_t vlo = wasm_v128_load(samples);
+		v128_t vhi = vlo;
+		for (i = 4; i + 4 <= count; i += 4)
+		{
+			v128_t v = wasm_v128_load(samples + i);
+			vlo = wasm_i32x4_min(vlo, v);
+			vhi = wasm_i32x4_max(vhi, v);
+		}
+		// fold the four lanes: swap halves, then neighbours
+		vlo = wasm_i32x4_min(vlo, wasm_i32x4_shuffle(vlo, vlo, 2, 3, 0, 1));
+		vhi = wasm_i32x4_max(vhi, wasm_i32x4_shuffle(vhi, vhi, 2, 3, 0, 1));
+		vlo = wasm_i32x4_min(vlo, wasm_i32x4_shuffle(vlo, vlo, 1, 0, 3, 2));
+		vhi = wasm_i32x4_max(vhi, wasm_i32x4_shuffle(vhi, vhi, 1, 0, 3, 2));
+		lo = wasm_i32x4_extract_lane(vlo, 0);
+		hi = wasm_i32x4_extract_lane(vhi, 0);
+	}
+#endif
+	for (; i < count; i++)
+	{
+		int v = samples[i];
+		lo = v < lo ? v : lo;
+		hi = v > hi ? v : hi;
+	}
+	minOut = lo;
+	maxOut = hi;
+}
+
+/**
+ * @brief signature of the plot output function, matches setPlotData()
+ */
+typedef void (*PlotDataFn)(int plot, int settings, int value);
+
+/**
+ * @brief counters kept by PlotFeeder
+ */
+struct PlotFeederStats
+{
+	unsigned int samples; ///< samples passed to push()
+	unsigned int emitted; ///< setPlotData() calls made
+	unsigned int pixels;  ///< pixel columns completed
+};
+
+/**
+ * @brief min/max envelope decimator in front of setPlotData().
+ *
+ * @code
+ * // 320 pixel plot showing 2000 ms (addControlPlotXAxis range) of 8 kHz samples: 50 samples per pixel
+ * static fwwasm::PlotFeeder feeder(PLOT_MIC, 320, 2000, 8000);
+ * feeder.push(block, blockLength);
+ * @endcode
+ */
+class PlotFeeder
+{
+public:
+	/**
+	 * @brief create a feeder
+	 * @param plot the index of the plot passed to setPlotData()
+	 * @param widthPixels the plot width
+	 * @param spanMs the time shown across the plot, iTimeMax - iTimeMin of addControlPlotXAxis()
+	 * @param sampleRateHz the rate samples are pushed at
+	 * @param plotFn the output function, setPlotData() unless a host stand-in is substituted
+	 */
+	PlotFeeder(int plot, unsigned int widthPixels, unsigned int spanMs, unsigned int sampleRateHz, PlotDataFn plotFn = setPlotData)
+		: m_plot(plot), m_plotFn(plotFn)
+	{
+		configure(widthPixels, spanMs, sampleRateHz);
+		memset(&m_stats, 0, sizeof(m_stats));
+	}
+
+	/**
+	 * @brief change the plot geometry or sample rate, discarding a partial pixel
+	 * @param widthPixels the plot width
+	 * @param spanMs the time shown across the plot
+	 * @param sampleRateHz the rate samples are pushed at
+	 */
+	void configure(unsigned int widthPixels, unsigned int spanMs, unsigned int sampleRateHz)
+	{
+		// samples per pixel in 16.16 fixed point so fractional rates do not drift
+		unsigned long long samples = static_cast<unsigned long long>(sampleRateHz) * spanMs;
+		unsigned long long perPixel = (samples << 16) / (1000ull * (widthPixels ? widthPixels : 1));
+		m_step = perPixel ? perPixel : 1;
+		m_accum = 0;
+		startPixel();
+	}
+
+	/// @brief samples per pixel in 16.16 fixed point
+	unsigned long long samplesPerPixel() const { return m_step; }
+
+	/**
+	 * @brief add samples; setPlotData() is called as pixel columns complete
+	 * @param samples the samples
+	 * @param count the number of samples
+	 */
+	void push(const int* samples, size_t count)
+	{
+		m_stats.samples += static_cast<unsigned int>(count);
+		// fewer than two samples per pixel: an envelope would send more values than the raw data
+		if (m_step < (2u << 16))
+		{
+			for (size_t i = 0; i < count; i++)
+				send(samples[i]);
+			return;
+		}
+		while (count)
+		{
+			size_t take = m_remaining < count ? m_remaining : count;
+			int lo, hi;
+			minMax(samples, take, lo, hi);
+			if (!m_filled)
+			{
+				m_first = samples[0];
+				m_lo = lo;
+				m_hi = hi;
+				m_filled = true;
+			}
+			else
+			{
+				m_lo = lo < m_lo ? lo : m_lo;
+				m_hi = hi > m_hi ? hi : m_hi;
+			}
+			m_last = samples[take - 1];
+			samples += take;
+			count -= take;
+			m_remaining -= take;
+			if (!m_remaining)
+				finishPixel();
+		}
+	}
+
+	/// @brief add one sample
+	void push(int sample) { push(&sample, 1); }
+
+	/// @brief emit a partially filled pixel column now
+	void flush()
+	{
+		if (m_filled)
+			finishPixel();
+	}
+
+	PlotFeederStats stats() const { return m_stats; }
+
+	void clearStats() { memset(&m_stats, 0, sizeof(m_stats)); }
+
+private:
+	PlotFeeder(const PlotFeeder&);
+	PlotFeeder& operator=(const PlotFeeder&);
+
+	void startPixel()
+	{
+		m_accum += m_step;
+		m_remaining = static_cast<size_t>(m_accum >> 16);
+		m_accum &= 0xFFFF;
+		if (!m_remaining)
+			m_remaining = 1;
+		m_filled = false;
+	}
+
+	void finishPixel()
+	{
+		// draw the envelope in the direction the signal moved so consecutive columns join up
+		if (m_lo == m_hi)
+			send(m_lo);
+		else if (m_last >= m_first)
+		{
+			send(m_lo);
+			send(m_hi);
+		}
+		else
+		{
+			send(m_hi);
+			send(m_lo);
+		}
+		m_stats.pixels++;
+		startPixel();
+	}
+
+	void send(int value)
+	{
+		m_plotFn(m_plot, 0, value);
+		m_stats.emitted++;
+	}
+
+	int m_plot;
+	PlotDataFn m_plotFn;
+	unsigned long long m_step;
+	unsigned long long m_accum;
+	size_t m_remaining;
+	bool m_filled;
+	int m_first;
+	int m_last;
+	int m_lo;
+	int m_hi;
+	PlotFeederStats m_stats;
+};
+
+} // namespace fwwasm
@@ -0,0 +1,144 @@
+/**
+@file
+	@brief Free-Wili wasm frame profiler
+Measures an app as the .wasm module it really is, on the device: FrameProfiler brackets each main loop iteration with
+millis() and reports frame time, the number of import calls the app counted into the frame and the linear memory
+high-water mark read with memory.size, so performance changes can be compared run to run from the numbers it prints.
+
+What it can and cannot see:
+ - millis() is the only clock the firmware offers, so a single frame is timed in whole milliseconds; the maximum and
+   the slow frame count are good to 1 ms. The average is total time over frames, which keeps fractions of a
+   millisecond once many frames have been measured, and is printed with two decimals.
+ - Import calls are not intercepted. The count is whatever the app passes to countImports(), for example the sum of
+   the helpers' stats() counters; without that it stays 0.
+ - There is no instruction count on the device. Off the device, tools/fwwasmbench.mjs runs an app's .wasm with every
+   import counted, see FWWASM_BUILD_WASM_BENCH.
+
+@code
+static fwwasm::FrameProfiler profile;
+while (1)
+{
+	profile.beginFrame();
+	...
+	profile.countImports(calls); // optional, e.g. from the helper stats() counters
+	profile.endFrame();
+	if (profile.frames() == 1000)
+	{
+		profile.print();
+		profile.reset();
+	}
+}
+@endcode
+*/
+#pragma once
+
+#include "fwwasm.h"
+#include "fwwasm_format.h"
+
+#include <stddef.h>
+#include <string.h>
+
+namespace fwwasm
+{
+
+/**
+ * @brief the size of linear memory in bytes, 0 on host builds
+ */
+inline size_t linearMemoryBytes()
+{
+#if defined(__wasm__)
+	return __builtin_wasm_memory_size(0) * 65536u;
+#else
+	return 0;
+#endif
+}
+
+/**
+ * @brief counters kept by FrameProfiler
+ */
+struct FrameProfileStats
+{
+	unsigned int frames;	  ///< frames measured
+	unsigned int totalMs;	  ///< time inside frames
+	unsigned int maxMs;		  ///< longest frame
+	unsigned int imports;	  ///< import calls the app reported with countImports()
+	unsigned int maxImports;  ///< most import calls in one frame
+	unsigned int memoryBytes; ///< linear memory high-water mark
+	unsigned int slowFrames;  ///< frames longer than the budget
+};
+
+/**
+ * @brief per frame time, import call and memory statistics
+ */
+class FrameProfiler
+{
+public:
+	/**
+	 * @brief create a profiler
+	 * @param budgetMs frames longer than this are counted as slow, 0 to disable
+	 */
+	explicit FrameProfiler(unsigned int budgetMs = 20) : m_budget(budgetMs), m_start(0), m_frameImports(0), m_inFrame(false)
+	{
+		reset();
+	}
+
+	/// @brief start measuring a frame
+	void beginFrame()
+	{
+		m_start = millis();
+		m_frameImports = 0;
+		m_inFrame = true;
+	}
+
+	/// @brief add import calls made in the current frame; the profiler does not count them itself
+	void countImports(unsigned int calls) { m_frameImports += calls; }
+
+	/// @brief finish the current frame
+	void endFrame()
+	{
+		if (!m_inFrame)
+			return;
+		m_inFrame = false;
+		unsigned int ms = millis() - m_start;
+		m_stats.frames++;
+		m_stats.totalMs += ms;
+		if (ms > m_stats.maxMs)
+			m_stats.maxMs = ms;
+		if (m_budget && ms > m_budget)
+			m_stats.slowFrames++;
+		m_stats.imports += m_frameImports;
+		if (m_frameImports > m_stats.maxImports)
+			m_stats.maxImports = m_frameImports;
+		unsigned int memory = static_cast<unsigned int>(linearMemoryBytes());
+		if (memory > m_stats.memoryBytes)
+			m_stats.memoryBytes = memory;
+	}
+
+	unsigned int frames() const { return m_stats.frames; }
+
+	/// @brief average frame time, finer than the 1 ms millis() resolution once enough frames are measured
+	float averageMs() const { return m_stats.frames ? static_cast<float>(m_stats.totalMs) / static_cast<float>(m_stats.frames) : 0.0f; }
+
+	FrameProfileStats stats() const { return m_stats; }
+
+	/// @brief print a one line summary with printInt()
+	void print(printOutColor color = printColorNormal) const
+	{
+		unsigned int frames = m_stats.frames ? m_stats.frames : 1;
+		fwwasm::print(color, "frames {} avg {:.2f} ms max {} ms slow {} imports/frame {} max {} memory {} KB\n", m_stats.frames,
+			averageMs(), m_stats.maxMs, m_stats.slowFrames, m_stats.imports / frames, m_stats.maxImports,
+			m_stats.memoryBytes / 1024);
+	}
+
+	/// @brief start a new measurement period
+	void reset() { memset(&m_stats, 0, sizeof(m_stats)); }
+
+private:
+	unsigned int m_budget;
+	unsigned int m_start;
+	unsigned int m_frameImports;
+	bool m_inFrame;
+	FrameProfileStats m_stats;
+};
+
+} // namespace fwwasm
@@ -0,0 +1,405 @@
+/**
+@file
+	@brief Free-Wili wasm compact binary sensor log
+Stores multi-channel fixed-point samples (for example accelerometer X/Y/Z in milli-g and temperature in hundredths of a
+degree from FWGUI_EVENT_GUI_SENSOR_DATA) as varint deltas with periodic keyframes and a trailing seek index.
+
+File layout, all integers little-endian:
+ - header: "FWSL", version (1 byte), channel count (1 byte), keyframe interval (2 bytes)
+ - keyframe: 0x01, timestamp ms (4 bytes), one zigzag varint absolute value per channel
+ - delta frame: 0x02, varint milliseconds since the previous sample, one zigzag varint delta per channel
+ - index (written by finish()): pairs of timestamp ms and file offset (4 bytes each) for keyframes
+ - trailer: index entry count (4 bytes), index offset (4 bytes), "FWSX"
+
+A log cut short by power loss has no index; SensorLogReader then falls back to scanning frames from the start.
+*/
+#pragma once
+
+#include "fwwasm.h"
+#include "fwwasm_file.h"
+
+#include <stddef.h>
+#include <string.h>
+
+namespace fwwasm
+{
+
+/// most channels a sensor log can carry
+#define FWWASM_SENSORLOG_MAX_CHANNELS 8
+
+enum
+{
+	sensorLogVersion = 1,
+	sensorLogHeaderBytes = 8,
+	sensorLogTrailerBytes = 12,
+	sensorLogKeyframe = 0x01,
+	sensorLogDelta = 0x02,
+};
+
+/**
+ * @brief one decoded sample
+ */
+struct SensorSample
+{
+	unsigned int timestampMs;
+	int values[FWWASM_SENSORLOG_MAX_CHANNELS];
+};
+
+/**
+ * @brief counters kept by SensorLogWriter
+ */
+struct SensorLogStats
+{
+	unsigned int samples;
+	unsigned int keyframes;
+	unsigned int bytes;		 ///< bytes written including header, index and trailer
+	unsigned int writeCalls; ///< writeFile() calls made
+};
+
+/**
+ * @brief device side writer for the binary sensor log.
+ * @tparam CHANNELS the number of values per sample
+ * @tparam INDEX_ENTRIES the seek index capacity; when full every other entry is discarded so long runs stay bounded
+ * @tparam BUFFER the write buffer size in bytes
+ *
+ * @code
+ * static fwwasm::SensorLogWriter<4> sensorLog;
+ * sensorLog.begin(openFile("accel.fwsl", mode));
+ * ...
+ * int values[4] = { x, y, z, tempCenti };
+ * sensorLog.add(millis(), values);
+ * ...
+ * sensorLog.finish();
+ * closeFile(handle);
+ * @endcode
+ */
+template <size_t CHANNELS, size_t INDEX_ENTRIES = 256, size_t BUFFER = 512>
+class SensorLogWriter
+{
+	static_assert(CHANNELS > 0 && CHANNELS <= FWWASM_SENSORLOG_MAX_CHANNELS, "unsupported channel count");
+	static_assert(INDEX_ENTRIES >= 2, "index needs at least two entries");
+
+public:
+	/**
+	 * @brief create a writer
+	 * @param keyframeInterval samples between keyframes, bounds how far a seek has to decode
+	 * @param writeFn the write function, writeFile() unless a host stand-in is substituted
+	 */
+	explicit SensorLogWriter(unsigned int keyframeInterval = 64, FileWriteFn writeFn = writeFile)
+		: m_keyframeInterval(keyframeInterval == 0 ? 1 : (keyframeInterval > 0xFFFF ? 0xFFFF : keyframeInterval)), m_out(-1, writeFn)
+	{
+		reset();
+	}
+
+	/**
+	 * @brief start a new log at the current position of a file
+	 * @param handle a handle returned by openFile(), positioned at the start of the file
+	 * @return true if the header was accepted
+	 */
+	bool begin(int handle)
+	{
+		m_out.setHandle(handle);
+		reset();
+		unsigned char header[sensorLogHeaderBytes] = { 'F', 'W', 'S', 'L', sensorLogVersion, static_cast<unsigned char>(CHANNELS),
+			static_cast<unsigned char>(m_keyframeInterval), static_cast<unsigned char>(m_keyframeInterval >> 8) };
+		return put(header, sizeof(header));
+	}
+
+	/**
+	 * @brief append one sample
+	 * @param timestampMs the sample time, typically millis()
+	 * @param values CHANNELS fixed-point values
+	 * @return true if the data was accepted by writeFile()
+	 */
+	bool add(unsigned int timestampMs, const int* values)
+	{
+		unsigned char frame[1 + 5 + CHANNELS * 5];
+		size_t n = 0;
+		bool key = m_sinceKey == 0 || m_sinceKey >= m_keyframeInterval || timestampMs < m_lastTime;
+		if (key)
+		{
+			addIndex(timestampMs, offset());
+			frame[n++] = sensorLogKeyframe;
+			detail::putU32(frame + n, timestampMs);
+			n += 4;
+			for (size_t c = 0; c < CHANNELS; c++)
+				n += detail::putVarint(frame + n, detail::zigzag(values[c]));
+			m_sinceKey = 0;
+			m_stats.keyframes++;
+		}
+		else
+		{
+			frame[n++] = sensorLogDelta;
+			n += detail::putVarint(frame + n, timestampMs - m_lastTime);
+			for (size_t c = 0; c < CHANNELS; c++)
+			{
+				// wrap-around subtraction so any int32 step encodes losslessly
+				unsigned int delta = static_cast<unsigned int>(values[c]) - static_cast<unsigned int>(m_last[c]);
+				n += detail::putVarint(frame + n, detail::zigzag(static_cast<int>(delta)));
+			}
+		}
+		m_sinceKey++;
+		m_lastTime = timestampMs;
+		memcpy(m_last, values, sizeof(m_last));
+		m_stats.samples++;
+		if (put(frame, n))
+			return true;
+		// a lost block may hold the frames later deltas build on, so restart from a keyframe
+		m_sinceKey = 0;
+		return false;
+	}
+
+	/**
+	 * @brief write the seek index and trailer and flush; the file can then be closed
+	 * @return true if everything was accepted by writeFile()
+	 */
+	bool finish()
+	{
+		unsigned int indexOffset = offset();
+		bool ok = true;
+		for (size_t i = 0; i < m_indexCount; i++)
+		{
+			unsigned char entry[8];
+			detail::putU32(entry, m_index[i].timestampMs);
+			detail::putU32(entry + 4, m_index[i].offset);
+			ok = put(entry, sizeof(entry)) && ok;
+		}
+		unsigned char trailer[sensorLogTrailerBytes];
+		detail::putU32(trailer, static_cast<unsigned int>(m_indexCount));
+		detail::putU32(trailer + 4, indexOffset);
+		memcpy(trailer + 8, "FWSX", 4);
+		ok = put(trailer, sizeof(trailer)) && ok;
+		return m_out.flush() && ok;
+	}
+
+	/// @brief push buffered frames to writeFile() without ending the log
+	bool flush() { return m_out.flush(); }
+
+	SensorLogStats stats() const
+	{
+		SensorLogStats s = m_stats;
+		s.writeCalls = m_out.stats().writeCalls;
+		return s;
+	}
+
+private:
+	SensorLogWriter(const SensorLogWriter&);
+	SensorLogWriter& operator=(const SensorLogWriter&);
+
+	struct IndexEntry
+	{
+		unsigned int timestampMs;
+		unsigned int offset;
+	};
+
+	void reset()
+	{
+		m_base = m_out.stats().written + static_cast<unsigned int>(m_out.pending());
+		m_sinceKey = 0;
+		m_lastTime = 0;
+		m_indexCount = 0;
+		m_indexStride = 1;
+		m_keySeen = 0;
+		memset(m_last, 0, sizeof(m_last));
+		memset(&m_stats, 0, sizeof(m_stats));
+	}
+
+	void addIndex(unsigned int timestampMs, unsigned int offset)
+	{
+		if (m_keySeen++ % m_indexStride)
+			return;
+		if (m_indexCount == INDEX_ENTRIES)
+		{
+			// keep every other entry and halve the index density from here on
+			for (size_t i = 0; i < INDEX_ENTRIES / 2; i++)
+				m_index[i] = m_index[i * 2];
+			m_indexCount = INDEX_ENTRIES / 2;
+			m_indexStride *= 2;
+			if ((m_keySeen - 1) % m_indexStride)
+				return;
+		}
+		m_index[m_indexCount].timestampMs = timestampMs;
+		m_index[m_indexCount].offset = offset;
+		m_indexCount++;
+	}
+
+	/// @brief file offset of the next frame: bytes writeFile() accepted plus bytes still buffered
+	unsigned int offset() const { return m_out.stats().written + static_cast<unsigned int>(m_out.pending()) - m_base; }
+
+	bool put(const unsigned char* data, size_t length)
+	{
+		if (!m_out.write(data, length))
+			return false;
+		m_stats.bytes += static_cast<unsigned int>(length);
+		return true;
+	}
+
+	unsigned int m_keyframeInterval;
+	unsigned int m_base;
+	unsigned int m_sinceKey;
+	unsigned int m_lastTime;
+	int m_last[CHANNELS];
+	IndexEntry m_index[INDEX_ENTRIES];
+	size_t m_indexCount;
+	unsigned int m_indexStride;
+	unsigned int m_keySeen;
+	SensorLogStats m_stats;
+	BufferedFileWriter<BUFFER> m_out;
+};
+
+/**
+ * @brief reader for the binary sensor log over an in-memory copy of the file.
+ *
+ * Intended for host side tools; uses no Free-Wili imports.
+ */
+class SensorLogReader
+{
+public:
+	/**
+	 * @brief open a log
+	 * @param data the file contents
+	 * @param size the file size in bytes
+	 */
+	SensorLogReader(const unsigned char* data, size_t size)
+		: m_data(data), m_end(size), m_pos(0), m_channels(0), m_index(nullptr), m_indexCount(0), m_lastTime(0)
+	{
+		memset(m_last, 0, sizeof(m_last));
+		if (size < sensorLogHeaderBytes || memcmp(data, "FWSL", 4) != 0 || data[4] != sensorLogVersion || data[5] == 0 ||
+			data[5] > FWWASM_SENSORLOG_MAX_CHANNELS)
+			return;
+		m_channels = data[5];
+		m_pos = sensorLogHeaderBytes;
+		if (size >= sensorLogHeaderBytes + sensorLogTrailerBytes && memcmp(data + size - 4, "FWSX", 4) == 0)
+		{
+			unsigned int count = detail::getU32(data + size - 12);
+			unsigned int offset = detail::getU32(data + size - 8);
+			if (offset >= sensorLogHeaderBytes && offset <= size - sensorLogTrailerBytes &&
+				count == (size - sensorLogTrailerBytes - offset) / 8)
+			{
+				m_index = data + offset;
+				m_indexCount = count;
+				m_end = offset;
+			}
+		}
+	}
+
+	/// @brief true if the header was recognised
+	bool valid() const { return m_channels != 0; }
+	/// @brief true if the log was finished and has a seek index
+	bool hasIndex() const { return m_index != nullptr; }
+	size_t channels() const { return m_channels; }
+
+	/// @brief restart decoding at the first sample
+	void rewind()
+	{
+		m_pos = valid() ? sensorLogHeaderBytes : 0;
+		m_lastTime = 0;
+	}
+
+	/**
+	 * @brief decode the next sample
+	 * @param sample receives the sample
+	 * @return false at the end of the data or on a damaged frame
+	 */
+	bool next(SensorSample& sample)
+	{
+		if (!valid() || m_pos >= m_end)
+			return false;
+		size_t pos = m_pos;
+		unsigned char tag = m_data[pos++];
+		unsigned int time;
+		int values[FWWASM_SENSORLOG_MAX_CHANNELS];
+		if (tag == sensorLogKeyframe)
+		{
+			if (m_end - pos < 4)
+				return false;
+			time = detail::getU32(m_data + pos);
+			pos += 4;
+			for (size_t c = 0; c < m_channels; c++)
+			{
+				unsigned int v;
+				if (!getVarint(pos, v))
+					return false;
+				values[c] = detail::unzigzag(v);
+			}
+		}
+		else if (tag == sensorLogDelta && m_pos != sensorLogHeaderBytes)
+		{
+			unsigned int dt;
+			if (!getVarint(pos, dt))
+				return false;
+			time = m_lastTime + dt;
+			for (size_t c = 0; c < m_channels; c++)
+			{
+				unsigned int v;
+				if (!getVarint(pos, v))
+					return false;
+				values[c] = static_cast<int>(static_cast<unsigned int>(m_last[c]) + static_cast<unsigned int>(detail::unzigzag(v)));
+			}
+		}
+		else
+			return false;
+		m_pos = pos;
+		m_lastTime = time;
+		memcpy(m_last, values, sizeof(int) * m_channels);
+		sample.timestampMs = time;
+		memcpy(sample.values, values, sizeof(int) * m_channels);
+		return true;
+	}
+
+	/**
+	 * @brief position the reader so next() returns the first sample at or after a time
+	 * @param timestampMs the time to seek to
+	 * @return false if no sample is at or after the time
+	 */
+	bool seek(unsigned int timestampMs)
+	{
+		rewind();
+		if (m_index)
+		{
+			// last indexed keyframe at or before the target
+			size_t lo = 0, hi = m_indexCount;
+			while (lo < hi)
+			{
+				size_t mid = (lo + hi) / 2;
+				if (detail::getU32(m_index + mid * 8) <= timestampMs)
+					lo = mid + 1;
+				else
+					hi = mid;
+			}
+			if (lo)
+				m_pos = detail::getU32(m_index + (lo - 1) * 8 + 4);
+		}
+		SensorSample sample;
+		while (true)
+		{
+			size_t pos = m_pos;
+			unsigned int lastTime = m_lastTime;
+			int last[FWWASM_SENSORLOG_MAX_CHANNELS];
+			memcpy(last, m_last, sizeof(last));
+			if (!next(sample))
+				return false;
+			if (sample.timestampMs >= timestampMs)
+			{
+				m_pos = pos;
+				m_lastTime = lastTime;
+				memcpy(m_last, last, sizeof(last));
+				return true;
+			}
+		}
+	}
+
+private:
+	bool getVarint(size_t& pos, unsigned int& value) const { return detail::getVarint(m_data, m_end, pos, value); }
+
+	const unsigned char* m_data;
+	size_t m_end;
+	size_t m_pos;
+	size_t m_channels;
+	const unsigned char* m_index;
+	size_t m_indexCount;
+	unsigned int m_lastTime;
+	int m_last[FWWASM_SENSORLOG_MAX_CHANNELS];
+};
+
+} // namespace fwwasm
@@ -0,0 +1,573 @@
+/**
+@file
+	@brief Free-Wili wasm sound sequencing and synthesis
+SoundQueue sequences playSoundFromFile(), playSoundFromNumber() and playSoundFromFrequencyAndDuration() calls: each
+item carries its play time, update() starts the next item in the same call that sees the previous one end (optionally
+a little early to hide start latency) and reports every finished item through a callback, which postSoundDone() turns
+into an FWWASM_EVENT_SOUND_DONE event for an EventQueue; a completion the callback refuses is kept and offered again.
+The firmware reports neither when a sound ends nor how long it is, so an item counts as finished when the durationMs
+the caller queued it with has passed: sequencing moves from waitms() calls into the queue, but is only as accurate as
+those durations.
+
+For generated audio, synthesize() renders the audioWaveType shapes into 16 bit PCM blocks, four samples per
+instruction with WASM SIMD128, and PcmRing is the single producer, single consumer ring those blocks are pushed into.
+The firmware has no PCM playback import yet; the ring's consumer is whatever drains it, a host stand-in today.
+*/
+#pragma once
+
+#include "fwwasm.h"
+#include "fwwasm_events.h"
+
+#include <stddef.h>
+#include <string.h>
+
+#if defined(__wasm_simd128__)
+#include <wasm_simd128.h>
+#endif
+
+/// @brief event type posted by postSoundDone(), the data holds a SoundDone
+#define FWWASM_EVENT_SOUND_DONE (FWWASM_APP_EVENT_BASE + 1)
+
+namespace fwwasm
+{
+
+/**
+ * @brief sound functions used by SoundQueue, defaults to the Free-Wili imports and can be replaced by a host stand-in
+ */
+struct SoundIO
+{
+	void (*playFile)(const char* file_name);
+	void (*playNumber)(int bFloat, int iNumber, float fNumber, int iFloatDigits);
+	void (*playTone)(float frequency, float duration, float amplitude, audioWaveType wavetype);
+};
+
+/// @brief SoundIO bound to playSoundFromFile(), playSoundFromNumber() and playSoundFromFrequencyAndDuration()
+inline SoundIO defaultSoundIO()
+{
+	SoundIO io = { playSoundFromFile, playSoundFromNumber, playSoundFromFrequencyAndDuration };
+	return io;
+}
+
+/**
+ * @brief a finished queue item
+ */
+struct SoundDone
+{
+	int id;				 ///< the value the enqueue call returned
+	unsigned int lateMs; ///< how long after its end update() noticed it, the gap before the next item
+};
+
+/// @brief signature of the completion callback, returns false if the completion could not be delivered yet
+typedef bool (*SoundDoneFn)(void* context, const SoundDone& done);
+
+/**
+ * @brief completion callback that posts to an EventQueue as FWWASM_EVENT_SOUND_DONE
+ * @tparam QUEUE the EventQueue type, the context is a pointer to it
+ * @return the result of post(), false while the queue's app lane is full
+ */
+template <typename QUEUE>
+bool postSoundDone(void* context, const SoundDone& done)
+{
+	Event ev;
+	ev.type = FWWASM_EVENT_SOUND_DONE;
+	memset(ev.data, 0, sizeof(ev.data));
+	memcpy(ev.data, &done, sizeof(done));
+	return static_cast<QUEUE*>(context)->post(ev);
+}
+
+/// @brief unpack a FWWASM_EVENT_SOUND_DONE event
+inline bool soundDoneFromEvent(const Event& ev, SoundDone& done)
+{
+	static_assert(sizeof(SoundDone) <= FW_GET_EVENT_DATA_MAX, "SoundDone must fit in an event");
+	if (ev.type != FWWASM_EVENT_SOUND_DONE)
+		return false;
+	memcpy(&done, ev.data, sizeof(done));
+	return true;
+}
+
+/**
+ * @brief counters kept by SoundQueue
+ */
+struct SoundQueueStats
+{
+	unsigned int queued;	///< items accepted
+	unsigned int rejected;	///< items refused because the queue was full
+	unsigned int played;	///< items started
+	unsigned int maxLateMs; ///< largest gap between an item's end and the next start
+	unsigned int retries;	///< completion callbacks that returned false, the completion was kept and offered again
+};
+
+/**
+ * @brief gapless playback queue.
+ * @tparam ITEMS the number of items that can wait, also the number of completions kept while the callback refuses them
+ * @tparam NAME_LEN the longest file name including the terminator
+ *
+ * @code
+ * static fwwasm::SoundQueue<> sound;
+ * sound.enqueueFile("reading.wav", 600);
+ * sound.enqueueNumber(42, 700);
+ * sound.enqueueTone(880.0f, 150);
+ * while (1)
+ *     sound.update(millis());
+ * @endcode
+ */
+template <size_t ITEMS = 16, size_t NAME_LEN = 32>
+class SoundQueue
+{
+public:
+	explicit SoundQueue(SoundIO io = defaultSoundIO())
+		: m_io(io), m_head(0), m_count(0), m_nextId(1), m_playing(false), m_currentId(0), m_end(0), m_leadMs(0), m_doneFn(nullptr),
+		  m_context(nullptr), m_doneHead(0), m_doneCount(0)
+	{
+		memset(&m_stats, 0, sizeof(m_stats));
+	}
+
+	/// @brief set the completion callback, see postSoundDone()
+	void onDone(SoundDoneFn fn, void* context)
+	{
+		m_doneFn = fn;
+		m_context = context;
+	}
+
+	/// @brief start each item this long before the previous one ends, to cover the firmware's start latency
+	void setLeadMs(unsigned int leadMs) { m_leadMs = leadMs; }
+
+	/**
+	 * @brief queue a sound file
+	 * @param fileName the file, copied
+	 * @param durationMs its play time
+	 * @return the item id, or -1 if the queue is full or the name too long
+	 */
+	int enqueueFile(const char* fileName, unsigned int durationMs)
+	{
+		if (strlen(fileName) >= NAME_LEN)
+			return reject();
+		Item* item = add(itemFile, durationMs);
+		if (!item)
+			return -1;
+		strcpy(item->name, fileName);
+		return item->id;
+	}
+
+	/// @brief queue a spoken integer, see enqueueFile()
+	int enqueueNumber(int value, unsigned int durationMs)
+	{
+		Item* item = add(itemNumber, durationMs);
+		if (!item)
+			return -1;
+		item->number = value;
+		return item->id;
+	}
+
+	/// @brief queue a spoken float with the given number of digits, see enqueueFile()
+	int enqueueFloat(float value, int digits, unsigned int durationMs)
+	{
+		Item* item = add(itemFloat, durationMs);
+		if (!item)
+			return -1;
+		item->value = value;
+		item->number = digits;
+		return item->id;
+	}
+
+	/// @brief queue a tone, see enqueueFile()
+	int enqueueTone(float frequency, unsigned int durationMs, float amplitude = 0.2f, audioWaveType wave = WAVETYPE_SINE)
+	{
+		Item* item = add(itemTone, durationMs);
+		if (!item)
+			return -1;
+		item->value = frequency;
+		item->amplitude = amplitude;
+		item->number = wave;
+		return item->id;
+	}
+
+	/// @brief queue a pause, see enqueueFile()
+	int enqueueSilence(unsigned int durationMs)
+	{
+		Item* item = add(itemSilence, durationMs);
+		return item ? item->id : -1;
+	}
+
+	/**
+	 * @brief offer refused completions again, then finish and start items; call every loop iteration
+	 * @param nowMs the current time, typically millis()
+	 * @return the number of items started
+	 */
+	unsigned int update(unsigned int nowMs)
+	{
+		deliver();
+		unsigned int started = 0;
+		while (true)
+		{
+			if (m_playing)
+			{
+				// with a lead time the item is reported done, and the next one started, slightly before its end
+				if (static_cast<int>(nowMs - (m_end - m_leadMs)) < 0)
+					break;
+				// every kept completion slot is taken: hold the sequence rather than lose one
+				if (m_doneCount == ITEMS)
+					break;
+				finish(nowMs);
+			}
+			if (!m_count)
+				break;
+			start(nowMs);
+			started++;
+		}
+		return started;
+	}
+
+	/// @brief drop queued items; the item playing is not interrupted
+	void clear() { m_count = 0; }
+
+	/// @brief true while an item is playing or queued, or a completion is waiting to be delivered
+	bool busy() const { return m_playing || m_count || m_doneCount; }
+
+	/// @brief number of items waiting
+	size_t pending() const { return m_count; }
+
+	SoundQueueStats stats() const { return m_stats; }
+
+private:
+	SoundQueue(const SoundQueue&);
+	SoundQueue& operator=(const SoundQueue&);
+
+	enum
+	{
+		itemFile = 0,
+		itemNumber,
+		itemFloat,
+		itemTone,
+		itemSilence,
+	};
+
+	struct Item
+	{
+		int id;
+		int kind;
+		unsigned int durationMs;
+		int number;
+		float value;
+		float amplitude;
+		char name[NAME_LEN];
+	};
+
+	int reject()
+	{
+		m_stats.rejected++;
+		return -1;
+	}
+
+	Item* add(int kind, unsigned int durationMs)
+	{
+		if (m_count == ITEMS)
+		{
+			reject();
+			return nullptr;
+		}
+		Item& item = m_items[(m_head + m_count) % ITEMS];
+		item.id = m_nextId++;
+		item.kind = kind;
+		item.durationMs = durationMs;
+		m_count++;
+		m_stats.queued++;
+		return &item;
+	}
+
+	void finish(unsigned int nowMs)
+	{
+		m_playing = false;
+		SoundDone done;
+		done.id = m_currentId;
+		done.lateMs = static_cast<int>(nowMs - m_end) > 0 ? nowMs - m_end : 0;
+		if (done.lateMs > m_stats.maxLateMs)
+			m_stats.maxLateMs = done.lateMs;
+		if (!m_doneFn)
+			return;
+		m_done[(m_doneHead + m_doneCount) % ITEMS] = done;
+		m_doneCount++;
+		deliver();
+	}
+
+	// Hands kept completions to the callback in order, stopping at the first it refuses.
+	void deliver()
+	{
+		while (m_doneCount)
+		{
+			if (!m_doneFn(m_context, m_done[m_doneHead]))
+			{
+				m_stats.retries++;
+				return;
+			}
+			m_doneHead = (m_doneHead + 1) % ITEMS;
+			m_doneCount--;
+		}
+	}
+
+	void start(unsigned int nowMs)
+	{
+		const Item& item = m_items[m_head];
+		m_head = (m_head + 1) % ITEMS;
+		m_count--;
+		switch (item.kind)
+		{
+			case itemFile:
+				m_io.playFile(item.name);
+				break;
+			case itemNumber:
+				m_io.playNumber(0, item.number, 0.0f, 0);
+				break;
+			case itemFloat:
+				m_io.playNumber(1, 0, item.value, item.number);
+				break;
+			case itemTone:
+				m_io.playTone(item.value, static_cast<float>(item.durationMs) / 1000.0f, item.amplitude,
+					static_cast<audioWaveType>(item.number));
+				break;
+			default:
+				break;
+		}
+		// an item started early plays on from the previous end, so lead time does not shorten the sequence
+		unsigned int base = m_stats.played && static_cast<int>(nowMs - m_end) < 0 ? m_end : nowMs;
+		m_currentId = item.id;
+		m_end = base + item.durationMs;
+		m_playing = true;
+		m_stats.played++;
+	}
+
+	SoundIO m_io;
+	size_t m_head;
+	size_t m_count;
+	int m_nextId;
+	bool m_playing;
+	int m_currentId;
+	unsigned int m_end;
+	unsigned int m_leadMs;
+	SoundDoneFn m_doneFn;
+	void* m_context;
+	size_t m_doneHead;
+	size_t m_doneCount;
+	SoundQueueStats m_stats;
+	Item m_items[ITEMS];
+	SoundDone m_done[ITEMS];
+};
+
+/**
+ * @brief phase accumulator for synthesize()
+ */
+struct Oscillator
+{
+	float phase;	 ///< position in the cycle, 0 to 1
+	float step;		 ///< cycles per sample, frequency / sample rate
+	float amplitude; ///< 0 to 1
+	audioWaveType wave;
+
+	static Oscillator make(float frequency, float sampleRate, float amplitude = 0.2f, audioWaveType wave = WAVETYPE_SINE)
+	{
+		Oscillator o = { 0.0f, frequency / sampleRate, amplitude, wave };
+		return o;
+	}
+};
+
+namespace detail
+{
+
+// One cycle of a wave shape at phase p in [0, 1), range -1 to 1. The sine is a refined parabola (error below 0.1%)
+// so the scalar and SIMD paths produce the same samples.
+inline float waveSample(audioWaveType wave, float p)
+{
+	switch (wave)
+	{
+		case WAVETYPE_SQUARE:
+			return p < 0.5f ? 1.0f : -1.0f;
+		case WAVETYPE_SAWTOOTH:
+			return 2.0f * p - 1.0f;
+		case WAVETYPE_TRIANGLE:
+			return 1.0f - 4.0f * (p < 0.5f ? 0.5f - p : p - 0.5f);
+		default:
+		{
+			float u = 2.0f * p - 1.0f;
+			float y = 4.0f * u * (1.0f - (u < 0 ? -u : u));
+			return -(0.225f * (y * (y < 0 ? -y : y) - y) + y);
+		}
+	}
+}
+
+} // namespace detail
+
+/**
+ * @brief render an oscillator into 16 bit PCM
+ * @param out receives the samples
+ * @param count the number of samples
+ * @param osc the oscillator, its phase advances
+ */
+inline void synthesize(short* out, size_t count, Oscillator& osc)
+{
+	size_t i = 0;
+	float scale = osc.amplitude * 32767.0f;
+#if defined(__wasm_simd128__)
+	const v128_t one = wasm_f32x4_splat(1.0f), two = wasm_f32x4_splat(2.0f), half = wasm_f32x4_splat(0.5f);
+	const v128_t vscale = wasm_f32x4_splat(scale);
+	const v128_t ramp = wasm_f32x4_mul(wasm_f32x4_make(0.0f, 1.0f, 2.0f, 3.0f), wasm_f32x4_splat(osc.step));
+	for (; i + 4 <= count; i += 4)
+	{
+		v128_t p = wasm_f32x4_add(wasm_f32x4_splat(osc.phase), ramp);
+		p = wasm_f32x4_sub(p, wasm_f32x4_floor(p));
+		v128_t s;
+		switch (osc.wave)
+		{
+			case WAVETYPE_SQUARE:
+				s = wasm_v128_bitselect(one, wasm_f32x4_neg(one), wasm_f32x4_lt(p, half));
+				break;
+			case WAVETYPE_SAWTOOTH:
+				s = wasm_f32x4_sub(wasm_f32x4_mul(two, p), one);
+				break;
+			case WAVETYPE_TRIANGLE:
+				s = wasm_f32x4_sub(one, wasm_f32x4_mul(wasm_f32x4_splat(4.0f), wasm_f32x4_abs(wasm_f32x4_sub(p, half))));
+				break;
+			default:
+			{
+				v128_t u = wasm_f32x4_sub(wasm_f32x4_mul(two, p), one);
+				v128_t y = wasm_f32x4_mul(wasm_f32x4_mul(wasm_f32x4_splat(4.0f), u), wasm_f32x4_sub(one, wasm_f32x4_abs(u)));
+				v128_t r = wasm_f32x4_sub(wasm_f32x4_mul(y, wasm_f32x4_abs(y)), y);
+				s = wasm_f32x4_neg(wasm_f32x4_add(wasm_f32x4_mul(wasm_f32x4_splat(0.225f), r), y));
+				break;
+			}
+		}
+		v128_t pcm = wasm_i32x4_trunc_sat_f32x4(wasm_f32x4_mul(s, vscale));
+		v128_t packed = wasm_i16x8_narrow_i32x4(pcm, pcm);
+		wasm_v128_store64_lane(out + i, packed, 0);
+		osc.phase += 4.0f * osc.step;
+		osc.phase -= static_cast<float>(static_cast<int>(osc.phase));
+	}
+#endif
+	for (; i < count; i++)
+	{
+		out[i] = static_cast<short>(detail::waveSample(osc.wave, osc.phase) * scale);
+		osc.phase += osc.step;
+		// truncating like the SIMD128 path keeps steps of a cycle or more in range
+		if (osc.phase >= 1.0f)
+			osc.phase -= static_cast<float>(static_cast<int>(osc.phase));
+	}
+}
+
+/**
+ * @brief counters kept by PcmRing, the first and last are updated by the producer, the others by the consumer
+ */
+struct PcmRingStats
+{
+	unsigned int written;	///< samples accepted by write()
+	unsigned int read;		///< samples returned by read(), including silence
+	unsigned int underruns; ///< read() calls that found too few samples
+	unsigned int silence;	///< zero samples returned in place of missing data
+	unsigned int overruns;	///< write() calls that found too little room
+};
+
+/**
+ * @brief single producer, single consumer ring of 16 bit PCM samples.
+ * @tparam SAMPLES the ring capacity
+ *
+ * write() only advances the write index and read() only the read index, so the producer and the consumer may run in
+ * different threads or in an interrupt and the main loop. Each index is published with release and read with acquire
+ * ordering, so the samples behind it are visible before it. Both indices run over 0 .. 2 * SAMPLES - 1, which tells a
+ * full ring from an empty one without a shared count.
+ *
+ * @code
+ * static fwwasm::PcmRing<2048> ring;
+ * static fwwasm::Oscillator osc = fwwasm::Oscillator::make(440.0f, 16000.0f);
+ * short block[256];
+ * while (ring.space() >= 256)
+ * {
+ *     fwwasm::synthesize(block, 256, osc);
+ *     ring.write(block, 256);
+ * }
+ * @endcode
+ */
+template <size_t SAMPLES>
+class PcmRing
+{
+public:
+	PcmRing() : m_read(0), m_write(0) { memset(&m_stats, 0, sizeof(m_stats)); }
+
+	/// @brief samples waiting to be read
+	size_t available() const { return used(__atomic_load_n(&m_write, __ATOMIC_ACQUIRE), __atomic_load_n(&m_read, __ATOMIC_ACQUIRE)); }
+
+	/// @brief room for more samples
+	size_t space() const { return SAMPLES - available(); }
+
+	/**
+	 * @brief add samples, called by the producer only
+	 * @return the number of samples stored, less than count when the ring is full
+	 */
+	size_t write(const short* samples, size_t count)
+	{
+		size_t write = m_write;
+		size_t room = SAMPLES - used(write, __atomic_load_n(&m_read, __ATOMIC_ACQUIRE));
+		if (count > room)
+		{
+			m_stats.overruns++;
+			count = room;
+		}
+		for (size_t done = 0; done < count;)
+		{
+			size_t tail = write % SAMPLES;
+			size_t run = SAMPLES - tail < count - done ? SAMPLES - tail : count - done;
+			memcpy(m_samples + tail, samples + done, run * sizeof(short));
+			write = advance(write, run);
+			done += run;
+		}
+		__atomic_store_n(&m_write, write, __ATOMIC_RELEASE);
+		m_stats.written += static_cast<unsigned int>(count);
+		return count;
+	}
+
+	/**
+	 * @brief take samples, padding with silence when the producer fell behind; called by the consumer only
+	 * @return the number of real samples, the rest of count is zero filled
+	 */
+	size_t read(short* out, size_t count)
+	{
+		size_t read = m_read;
+		size_t ready = used(__atomic_load_n(&m_write, __ATOMIC_ACQUIRE), read);
+		size_t have = ready < count ? ready : count;
+		for (size_t done = 0; done < have;)
+		{
+			size_t head = read % SAMPLES;
+			size_t run = SAMPLES - head < have - done ? SAMPLES - head : have - done;
+			memcpy(out + done, m_samples + head, run * sizeof(short));
+			read = advance(read, run);
+			done += run;
+		}
+		__atomic_store_n(&m_read, read, __ATOMIC_RELEASE);
+		if (have < count)
+		{
+			memset(out + have, 0, (count - have) * sizeof(short));
+			m_stats.underruns++;
+			m_stats.silence += static_cast<unsigned int>(count - have);
+		}
+		m_stats.read += static_cast<unsigned int>(count);
+		return have;
+	}
+
+	PcmRingStats stats() const { return m_stats; }
+
+private:
+	PcmRing(const PcmRing&);
+	PcmRing& operator=(const PcmRing&);
+
+	static size_t used(size_t write, size_t read) { return write >= read ? write - read : 2 * SAMPLES - read + write; }
+
+	static size_t advance(size_t index, size_t count)
+	{
+		index += count;
+		return index >= 2 * SAMPLES ? index - 2 * SAMPLES : index;
+	}
+
+	size_t m_read;	///< owned by the consumer
+	size_t m_write; ///< owned by the producer
+	PcmRingStats m_stats;
+	short m_samples[SAMPLES];
+};
+
+} // namespace fwwasm
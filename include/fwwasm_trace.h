@@ -0,0 +1,520 @@
+/**
+@file
+	@brief Free-Wili wasm import record and replay
+ImportTrace sits between the app and the imports that bring outside timing and data into it: millis(), wilirand(),
+hasEvent(), getEventData(), UARTDataRxCount(), UARTDataRead(), RadioGetRxCount() and RadioRead(). In record mode every
+call goes to the firmware and its result is appended to a compact trace file on the SD card; in replay mode, typically
+in a native build of the same app on the host, the calls are answered from the trace instead, so field runs can be
+reproduced, profiled and bisected at a desk. traceEventSource() routes an EventQueue through the trace.
+
+Trace layout: an 8 byte header ("FWTR", version, 3 reserved bytes) followed by one record per call, a tag byte and
+varints (LEB128, zigzag for signed values):
+ - millis: time since the previous millis record
+ - wilirand, hasEvent, UARTDataRxCount: the result
+ - getEventData: the event type, the payload length without trailing zeros and the payload
+ - UARTDataRead: the requested length, the result and, on success, the result bytes read (version 1 traces stored
+   the full requested length)
+ - RadioGetRxCount: the radio index and the result
+ - RadioRead: the radio index, the requested length, the result and the bytes read
+*/
+#pragma once
+
+#include "fwwasm.h"
+#include "fwwasm_events.h"
+#include "fwwasm_file.h"
+
+#include <stddef.h>
+#include <string.h>
+
+namespace fwwasm
+{
+
+/**
+ * @brief record tags, one per traced import
+ */
+typedef enum _TraceImport
+{
+	traceMillis = 1,
+	traceWilirand,
+	traceHasEvent,
+	traceGetEventData,
+	traceUARTRxCount,
+	traceUARTRead,
+	traceRadioRxCount,
+	traceRadioRead,
+	traceImportCount,
+} TraceImport;
+
+/**
+ * @brief one decoded trace record
+ */
+struct TraceRecord
+{
+	int import;				   ///< see TraceImport
+	unsigned int millis;	   ///< for traceMillis, the reconstructed millis() value
+	int value;				   ///< the import's result
+	int index;				   ///< the radio index
+	int length;				   ///< the requested read length
+	const unsigned char* data; ///< returned bytes, points into the trace
+	size_t dataLength;
+};
+
+/**
+ * @brief sequential reader for a trace held in memory
+ */
+class TraceReader
+{
+public:
+	TraceReader(const unsigned char* data, size_t size) : m_data(data), m_size(size), m_pos(kHeaderBytes), m_millis(0), m_version(0)
+	{
+		m_valid = size >= kHeaderBytes && memcmp(data, "FWTR", 4) == 0 && data[4] >= 1 && data[4] <= kVersion;
+		if (m_valid)
+			m_version = data[4];
+	}
+
+	bool valid() const { return m_valid; }
+
+	/// @brief true when every record has been read
+	bool atEnd() const { return !m_valid || m_pos >= m_size; }
+
+	/// @brief offset of the next record
+	size_t offset() const { return m_pos; }
+
+	/// @brief the TraceImport of the next record without consuming it, -1 at the end
+	int peek() const { return atEnd() ? -1 : m_data[m_pos]; }
+
+	/**
+	 * @brief decode the next record
+	 * @return false at the end of the trace or on a damaged record
+	 */
+	bool next(TraceRecord& r)
+	{
+		if (atEnd())
+			return false;
+		size_t pos = m_pos;
+		r.import = m_data[pos++];
+		r.value = 0;
+		r.index = 0;
+		r.length = 0;
+		r.data = nullptr;
+		r.dataLength = 0;
+		r.millis = m_millis;
+		unsigned int v = 0;
+		switch (r.import)
+		{
+			case traceMillis:
+				if (!get(pos, v))
+					return false;
+				m_millis += v;
+				r.millis = m_millis;
+				r.value = static_cast<int>(m_millis);
+				break;
+			case traceWilirand:
+			case traceHasEvent:
+			case traceUARTRxCount:
+				if (!getSigned(pos, r.value))
+					return false;
+				break;
+			case traceGetEventData:
+				if (!getSigned(pos, r.value) || !get(pos, v) || !getData(pos, v, r))
+					return false;
+				break;
+			case traceUARTRead:
+				if (!getSigned(pos, r.length) || !getSigned(pos, r.value))
+					return false;
+				if (r.value > 0 && !getData(pos, static_cast<unsigned int>(m_version == 1 ? r.length : r.value), r))
+					return false;
+				break;
+			case traceRadioRxCount:
+				if (!getSigned(pos, r.index) || !getSigned(pos, r.value))
+					return false;
+				break;
+			case traceRadioRead:
+				if (!getSigned(pos, r.index) || !getSigned(pos, r.length) || !getSigned(pos, r.value))
+					return false;
+				if (r.value > 0 && !getData(pos, static_cast<unsigned int>(r.value), r))
+					return false;
+				break;
+			default:
+				return false;
+		}
+		m_pos = pos;
+		return true;
+	}
+
+	static const size_t kHeaderBytes = 8;
+	static const unsigned char kVersion = 2;
+
+private:
+	bool get(size_t& pos, unsigned int& value) const { return detail::getVarint(m_data, m_size, pos, value); }
+
+	bool getSigned(size_t& pos, int& value) const
+	{
+		unsigned int v;
+		if (!get(pos, v))
+			return false;
+		value = detail::unzigzag(v);
+		return true;
+	}
+
+	bool getData(size_t& pos, unsigned int length, TraceRecord& r) const
+	{
+		if (length > m_size - pos)
+			return false;
+		r.data = m_data + pos;
+		r.dataLength = length;
+		pos += length;
+		return true;
+	}
+
+	const unsigned char* m_data;
+	size_t m_size;
+	size_t m_pos;
+	unsigned int m_millis;
+	unsigned char m_version;
+	bool m_valid;
+};
+
+/**
+ * @brief the imports ImportTrace calls when recording or passing through; a replay-only host build can pass TraceImports()
+ */
+struct TraceImports
+{
+	unsigned int (*millis)(void);
+	int (*wilirand)(void);
+	int (*hasEvent)(void);
+	int (*getEventData)(unsigned char* data);
+	int (*UARTDataRxCount)(void);
+	int (*UARTDataRead)(unsigned char* data, int length);
+	int (*RadioGetRxCount)(int index);
+	int (*RadioRead)(int index, unsigned char* data, int length);
+};
+
+/// @brief TraceImports bound to the Free-Wili imports
+inline TraceImports defaultTraceImports()
+{
+	TraceImports io = { millis, wilirand, hasEvent, getEventData, UARTDataRxCount, UARTDataRead, RadioGetRxCount, RadioRead };
+	return io;
+}
+
+/**
+ * @brief counters kept by ImportTrace
+ */
+struct TraceStats
+{
+	unsigned int calls[traceImportCount]; ///< traced calls per TraceImport
+	unsigned int bytes;					  ///< trace bytes written or consumed
+	unsigned int divergences;			  ///< replayed calls that did not match the next record
+	unsigned int pastEnd;				  ///< replayed calls made after the last record, answered with 0 and not divergences
+};
+
+/**
+ * @brief records or replays the input imports of an app.
+ * @tparam BUFFER write buffer size in bytes when recording
+ *
+ * @code
+ * static fwwasm::ImportTrace<> trace;
+ * trace.record(openFile("run.trc", mode));  // on the device
+ * // trace.replay(data, size);              // in a host build of the same app
+ * static fwwasm::EventQueue<> events(fwwasm::traceEventSource(trace));
+ * while (1)
+ * {
+ *     unsigned int now = trace.millis();
+ *     ...
+ * }
+ * @endcode
+ */
+template <size_t BUFFER = 512>
+class ImportTrace
+{
+public:
+	/**
+	 * @brief create a trace in pass-through mode
+	 * @param io the imports used when recording or passing through
+	 * @param writeFn the trace file write function, writeFile() unless a host stand-in is substituted
+	 */
+	explicit ImportTrace(TraceImports io = defaultTraceImports(), FileWriteFn writeFn = writeFile)
+		: m_io(io), m_mode(modePass), m_reader(nullptr, 0), m_lastMillis(0), m_exhausted(false), m_out(-1, writeFn)
+	{
+		memset(&m_stats, 0, sizeof(m_stats));
+	}
+
+	/**
+	 * @brief start recording; calls before this pass straight through
+	 * @param handle an open, writable file; ImportTrace does not close it, call flush() first
+	 */
+	bool record(int handle)
+	{
+		if (handle < 0)
+			return false;
+		m_out.setHandle(handle);
+		unsigned char header[TraceReader::kHeaderBytes] = { 'F', 'W', 'T', 'R', TraceReader::kVersion, 0, 0, 0 };
+		m_mode = modeRecord;
+		// the first millis record holds the absolute time
+		m_lastMillis = 0;
+		emit(header, sizeof(header));
+		return true;
+	}
+
+	/**
+	 * @brief answer calls from a trace; the data must outlive the replay
+	 * @return false if the data is not a trace
+	 */
+	bool replay(const unsigned char* data, size_t size)
+	{
+		m_reader = TraceReader(data, size);
+		m_mode = m_reader.valid() ? modeReplay : modePass;
+		m_lastMillis = 0;
+		return m_reader.valid();
+	}
+
+	/// @brief true while replaying and records remain
+	bool replaying() const { return m_mode == modeReplay && !m_reader.atEnd(); }
+
+	/// @brief push buffered records to the card
+	bool flush() { return m_mode != modeRecord || m_out.flush(); }
+
+	unsigned int millis()
+	{
+		TraceRecord r;
+		if (m_mode == modeReplay)
+		{
+			if (expect(r, traceMillis))
+				return r.millis;
+			diverge();
+			return m_lastMillis;
+		}
+		unsigned int now = m_io.millis();
+		if (m_mode == modeRecord)
+		{
+			unsigned char rec[6];
+			rec[0] = traceMillis;
+			emit(rec, 1 + detail::putVarint(rec + 1, now - m_lastMillis));
+		}
+		m_lastMillis = now;
+		count(traceMillis);
+		return now;
+	}
+
+	int wilirand() { return simple(traceWilirand, m_io.wilirand); }
+
+	int hasEvent() { return simple(traceHasEvent, m_io.hasEvent); }
+
+	int UARTDataRxCount() { return simple(traceUARTRxCount, m_io.UARTDataRxCount); }
+
+	int getEventData(unsigned char* data)
+	{
+		TraceRecord r;
+		if (m_mode == modeReplay)
+		{
+			memset(data, 0, FW_GET_EVENT_DATA_MAX);
+			if (!expect(r, traceGetEventData))
+			{
+				diverge();
+				return -1;
+			}
+			memcpy(data, r.data, r.dataLength > FW_GET_EVENT_DATA_MAX ? FW_GET_EVENT_DATA_MAX : r.dataLength);
+			return r.value;
+		}
+		int type = m_io.getEventData(data);
+		if (m_mode == modeRecord)
+		{
+			size_t length = FW_GET_EVENT_DATA_MAX;
+			while (length && !data[length - 1])
+				length--;
+			unsigned char rec[11];
+			size_t n = 0;
+			rec[n++] = traceGetEventData;
+			n += detail::putVarint(rec + n, detail::zigzag(type));
+			n += detail::putVarint(rec + n, static_cast<unsigned int>(length));
+			emit(rec, n);
+			emit(data, length);
+		}
+		count(traceGetEventData);
+		return type;
+	}
+
+	int UARTDataRead(unsigned char* data, int length)
+	{
+		TraceRecord r;
+		if (m_mode == modeReplay)
+		{
+			// a record holding more than the caller's buffer takes is a different call
+			if (!expect(r, traceUARTRead) || r.length != length || r.value > length || r.dataLength > static_cast<unsigned int>(length))
+				return diverge();
+			if (r.value > 0)
+				memcpy(data, r.data, r.dataLength);
+			return r.value;
+		}
+		int result = m_io.UARTDataRead(data, length);
+		if (result > length)
+			result = length;
+		if (m_mode == modeRecord)
+		{
+			unsigned char rec[11];
+			size_t n = 0;
+			rec[n++] = traceUARTRead;
+			n += detail::putVarint(rec + n, detail::zigzag(length));
+			n += detail::putVarint(rec + n, detail::zigzag(result));
+			emit(rec, n);
+			// only the bytes that arrived, not the whole buffer
+			if (result > 0)
+				emit(data, static_cast<size_t>(result));
+		}
+		count(traceUARTRead);
+		return result;
+	}
+
+	int RadioGetRxCount(int index)
+	{
+		TraceRecord r;
+		if (m_mode == modeReplay)
+			return expect(r, traceRadioRxCount) && r.index == index ? r.value : diverge();
+		int result = m_io.RadioGetRxCount(index);
+		if (m_mode == modeRecord)
+		{
+			unsigned char rec[11];
+			size_t n = 0;
+			rec[n++] = traceRadioRxCount;
+			n += detail::putVarint(rec + n, detail::zigzag(index));
+			n += detail::putVarint(rec + n, detail::zigzag(result));
+			emit(rec, n);
+		}
+		count(traceRadioRxCount);
+		return result;
+	}
+
+	int RadioRead(int index, unsigned char* data, int length)
+	{
+		TraceRecord r;
+		if (m_mode == modeReplay)
+		{
+			if (!expect(r, traceRadioRead) || r.index != index || r.length != length || r.value > length ||
+				r.dataLength > static_cast<unsigned int>(length))
+				return diverge();
+			if (r.value > 0)
+				memcpy(data, r.data, r.dataLength);
+			return r.value;
+		}
+		int result = m_io.RadioRead(index, data, length);
+		if (result > length)
+			result = length;
+		if (m_mode == modeRecord)
+		{
+			unsigned char rec[16];
+			size_t n = 0;
+			rec[n++] = traceRadioRead;
+			n += detail::putVarint(rec + n, detail::zigzag(index));
+			n += detail::putVarint(rec + n, detail::zigzag(length));
+			n += detail::putVarint(rec + n, detail::zigzag(result));
+			emit(rec, n);
+			if (result > 0)
+				emit(data, static_cast<size_t>(result));
+		}
+		count(traceRadioRead);
+		return result;
+	}
+
+	TraceStats stats() const { return m_stats; }
+
+private:
+	ImportTrace(const ImportTrace&);
+	ImportTrace& operator=(const ImportTrace&);
+
+	enum
+	{
+		modePass = 0,
+		modeRecord,
+		modeReplay,
+	};
+
+	void count(int import) { m_stats.calls[import]++; }
+
+	void emit(const unsigned char* data, size_t length)
+	{
+		m_stats.bytes += static_cast<unsigned int>(length);
+		m_out.write(data, length);
+	}
+
+	int simple(int import, int (*fn)(void))
+	{
+		TraceRecord r;
+		if (m_mode == modeReplay)
+			return expect(r, import) ? r.value : diverge();
+		int result = fn();
+		if (m_mode == modeRecord)
+		{
+			unsigned char rec[6];
+			rec[0] = static_cast<unsigned char>(import);
+			emit(rec, 1 + detail::putVarint(rec + 1, detail::zigzag(result)));
+		}
+		count(import);
+		return result;
+	}
+
+	// Reads the next record if it is for this import. A record for a different import means the app no longer follows
+	// the trace; it is left in place for the call it belongs to, so one extra or missing call does not shift every later
+	// answer. The caller answers a false return through diverge().
+	bool expect(TraceRecord& r, int import)
+	{
+		m_exhausted = m_reader.atEnd();
+		if (m_exhausted || m_reader.peek() != import)
+			return false;
+		size_t before = m_reader.offset();
+		if (!m_reader.next(r))
+			return false;
+		m_stats.bytes += static_cast<unsigned int>(m_reader.offset() - before);
+		if (import == traceMillis)
+			m_lastMillis = r.millis;
+		count(import);
+		return true;
+	}
+
+	// Counts a call the trace could not answer, once: a replay that simply runs past the recording is not a divergence.
+	int diverge()
+	{
+		if (m_exhausted)
+			m_stats.pastEnd++;
+		else
+			m_stats.divergences++;
+		return 0;
+	}
+
+	TraceImports m_io;
+	int m_mode;
+	TraceReader m_reader;
+	unsigned int m_lastMillis;
+	bool m_exhausted;
+	TraceStats m_stats;
+	BufferedFileWriter<BUFFER> m_out;
+};
+
+namespace detail
+{
+
+template <size_t BUFFER>
+struct TraceEventThunks
+{
+	static ImportTrace<BUFFER>* trace;
+	static int hasEvent() { return trace->hasEvent(); }
+	static int getEventData(unsigned char* data) { return trace->getEventData(data); }
+};
+
+template <size_t BUFFER>
+ImportTrace<BUFFER>* TraceEventThunks<BUFFER>::trace = nullptr;
+
+} // namespace detail
+
+/**
+ * @brief EventSource that reads events through a trace, for EventQueue
+ * @param trace the trace; one trace per BUFFER size can be bound at a time
+ */
+template <size_t BUFFER>
+EventSource traceEventSource(ImportTrace<BUFFER>& trace)
+{
+	detail::TraceEventThunks<BUFFER>::trace = &trace;
+	EventSource source = { detail::TraceEventThunks<BUFFER>::hasEvent, detail::TraceEventThunks<BUFFER>::getEventData };
+	return source;
+}
+
+} // namespace fwwasm
@@ -0,0 +1,385 @@
+/**
+@file
+	@brief Free-Wili wasm WILEye capture queue
+The wilEye imports block and each setting is its own call. WilEyeCapture queues capture requests, each with the
+settings it needs, and update() runs at most one of them per call: only settings that differ from what the camera
+already has are sent, all of them before the shot, and a failed setting cancels the shot instead of taking it with a
+partial configuration. Completion is reported through a callback; postWilEyeShot() delivers it as an
+FWWASM_EVENT_WILEYE_SHOT event through an EventQueue so it is handled alongside the firmware events. A shot the callback
+cannot deliver is kept and offered again by the next update() before any further request runs, so none is lost.
+
+fetchWilEyeEvents() copies the camera's event queue in one pass. The firmware does not document the layout behind
+wilEyeGetEvent(), so each record keeps the first FWWASM_WILEYE_EVENT_WORDS integers as they were returned.
+
+@code
+static fwwasm::EventQueue<> events;
+static fwwasm::WilEyeCapture<> eye;
+eye.onShot(fwwasm::postWilEyeShot<fwwasm::EventQueue<> >, &events);
+fwwasm::WilEyeSettings s = fwwasm::WilEyeSettings::unchanged();
+s.zoom = wilEyeZoomLevel2x;
+s.resolution = wilEyeRes1280x720;
+eye.capture(s, wilEyeFileDestSDCard, "part1.jpg");
+while (1)
+{
+	eye.update();
+	fwwasm::Event ev;
+	while (events.next(ev))
+		if (ev.type == FWWASM_EVENT_WILEYE_SHOT)
+			...
+}
+@endcode
+*/
+#pragma once
+
+#include "fwwasm.h"
+#include "fwwasm_events.h"
+
+#include <stddef.h>
+#include <string.h>
+
+#ifndef FWWASM_WILEYE_EVENT_WORDS
+/// @brief integers kept from each wilEyeGetEvent() result
+#define FWWASM_WILEYE_EVENT_WORDS 4
+#endif
+
+/// @brief event type posted by postWilEyeShot(), the data holds a WilEyeShot
+#define FWWASM_EVENT_WILEYE_SHOT (FWWASM_APP_EVENT_BASE + 0)
+
+namespace fwwasm
+{
+
+/**
+ * @brief the settings a WilEyeSettings can carry, in the order they are applied
+ */
+typedef enum _WilEyeSetting
+{
+	wilEyeSettingResolution = 0,
+	wilEyeSettingZoom,
+	wilEyeSettingContrast,
+	wilEyeSettingBrightness,
+	wilEyeSettingSaturation,
+	wilEyeSettingHue,
+	wilEyeSettingFlash,
+	wilEyeSettingCount,
+} WilEyeSetting;
+
+/**
+ * @brief camera functions used by WilEyeCapture, defaults to the Free-Wili imports and can be replaced by a host stand-in
+ */
+struct WilEyeIO
+{
+	int (*takePicture)(int iDestination, const char* sFileName);
+	int (*startVideo)(int iDestination, const char* sFileName);
+	int (*stopVideo)(void);
+	int (*setting[wilEyeSettingCount])(int value); ///< indexed by WilEyeSetting
+	int (*getEventCount)(void);
+	int* (*getEvent)(int index);
+};
+
+/// @brief WilEyeIO bound to the wilEye imports
+inline WilEyeIO defaultWilEyeIO()
+{
+	WilEyeIO io = { wilEyeTakePicture, wilEyeStartVideo, wilEyeStopVideo,
+		{ wilEyeSetResolution, wilEyeSetZoom, wilEyeSetContrast, wilEyeSetBrightness, wilEyeSetSaturation, wilEyeSetHue, wilEyeSetFlash },
+		wilEyeGetEventCount, wilEyeGetEvent };
+	return io;
+}
+
+/**
+ * @brief camera settings for one capture, kUnchanged leaves a setting as it is
+ */
+struct WilEyeSettings
+{
+	int resolution; ///< see WILEyeResolution
+	int zoom;		///< see WILEyeZoomLevel
+	int contrast;	///< 0 to 100
+	int brightness; ///< 0 to 100
+	int saturation; ///< 0 to 100
+	int hue;		///< 0 to 100
+	int flash;		///< 1 for on
+
+	static const int kUnchanged = -1;
+
+	/// @brief settings that change nothing
+	static WilEyeSettings unchanged()
+	{
+		WilEyeSettings s = { kUnchanged, kUnchanged, kUnchanged, kUnchanged, kUnchanged, kUnchanged, kUnchanged };
+		return s;
+	}
+};
+
+/**
+ * @brief outcome of one capture request
+ */
+struct WilEyeShot
+{
+	int id;				   ///< the value capture() returned
+	int ok;				   ///< 1 if the picture or video call succeeded
+	int failedSetting;	   ///< the WilEyeSetting that failed, -1 if none did
+	unsigned int blockedMs; ///< time spent inside the wilEye imports for this request
+};
+
+/// @brief signature of the completion callback, returns false if the shot could not be delivered yet
+typedef bool (*WilEyeShotFn)(void* context, const WilEyeShot& shot);
+
+/**
+ * @brief completion callback that posts the shot to an EventQueue as FWWASM_EVENT_WILEYE_SHOT
+ * @tparam QUEUE the EventQueue type, the context is a pointer to it
+ * @return the result of post(), false while the queue's app lane is full
+ */
+template <typename QUEUE>
+bool postWilEyeShot(void* context, const WilEyeShot& shot)
+{
+	Event ev;
+	ev.type = FWWASM_EVENT_WILEYE_SHOT;
+	memset(ev.data, 0, sizeof(ev.data));
+	memcpy(ev.data, &shot, sizeof(shot));
+	return static_cast<QUEUE*>(context)->post(ev);
+}
+
+/// @brief unpack a FWWASM_EVENT_WILEYE_SHOT event
+inline bool wilEyeShotFromEvent(const Event& ev, WilEyeShot& shot)
+{
+	static_assert(sizeof(WilEyeShot) <= FW_GET_EVENT_DATA_MAX, "WilEyeShot must fit in an event");
+	if (ev.type != FWWASM_EVENT_WILEYE_SHOT)
+		return false;
+	memcpy(&shot, ev.data, sizeof(shot));
+	return true;
+}
+
+/**
+ * @brief one entry of the camera event queue
+ */
+struct WilEyeEventRecord
+{
+	int index;
+	int words[FWWASM_WILEYE_EVENT_WORDS];
+};
+
+/**
+ * @brief copy the camera event queue
+ * @param records receives the events, oldest first
+ * @param maxRecords the size of records
+ * @param io the camera functions
+ * @return the number of records filled
+ */
+inline size_t fetchWilEyeEvents(WilEyeEventRecord* records, size_t maxRecords, const WilEyeIO& io = defaultWilEyeIO())
+{
+	int count = io.getEventCount();
+	size_t filled = 0;
+	for (int i = 0; i < count && filled < maxRecords; i++)
+	{
+		const int* raw = io.getEvent(i);
+		if (!raw)
+			continue;
+		WilEyeEventRecord& r = records[filled++];
+		r.index = i;
+		memcpy(r.words, raw, sizeof(r.words));
+	}
+	return filled;
+}
+
+/**
+ * @brief counters kept by WilEyeCapture
+ */
+struct WilEyeStats
+{
+	unsigned int requests;		  ///< capture() and video requests accepted
+	unsigned int rejected;		  ///< requests refused because the queue was full
+	unsigned int shots;			  ///< requests completed successfully
+	unsigned int failures;		  ///< requests that failed in a setting or the capture call
+	unsigned int settingCalls;	  ///< wilEyeSet*() calls made
+	unsigned int settingsSkipped; ///< settings not sent because the camera already had them
+	unsigned int blockedMs;		  ///< total time inside the wilEye imports
+	unsigned int maxBlockedMs;	  ///< longest single update()
+	unsigned int retries;		  ///< completion callbacks that returned false, the shot was kept and offered again
+};
+
+/**
+ * @brief queue of camera requests run one per update().
+ * @tparam QUEUE the number of requests that can wait
+ * @tparam NAME_LEN the longest file name including the terminator
+ */
+template <size_t QUEUE = 4, size_t NAME_LEN = 48>
+class WilEyeCapture
+{
+public:
+	explicit WilEyeCapture(WilEyeIO io = defaultWilEyeIO())
+		: m_io(io), m_head(0), m_count(0), m_nextId(1), m_shotFn(nullptr), m_context(nullptr), m_undelivered(false)
+	{
+		memset(&m_stats, 0, sizeof(m_stats));
+		invalidate();
+	}
+
+	/// @brief set the completion callback, see postWilEyeShot()
+	void onShot(WilEyeShotFn fn, void* context)
+	{
+		m_shotFn = fn;
+		m_context = context;
+	}
+
+	/**
+	 * @brief queue a picture
+	 * @param settings applied before the shot
+	 * @param destination see WILEyeFileDestination
+	 * @param fileName the picture file name, copied
+	 * @return the request id reported in WilEyeShot, or -1 if the queue is full or the name too long
+	 */
+	int capture(const WilEyeSettings& settings, int destination, const char* fileName)
+	{
+		return queue(opPicture, settings, destination, fileName);
+	}
+
+	/// @brief queue the start of a video, see capture()
+	int startVideo(const WilEyeSettings& settings, int destination, const char* fileName)
+	{
+		return queue(opStartVideo, settings, destination, fileName);
+	}
+
+	/// @brief queue the end of a video, see capture()
+	int stopVideo() { return queue(opStopVideo, WilEyeSettings::unchanged(), 0, ""); }
+
+	/**
+	 * @brief run the oldest queued request, call every loop iteration; a shot the callback refused is offered again
+	 * first and no request runs until it is delivered
+	 * @return true if a request was run
+	 */
+	bool update()
+	{
+		if (m_undelivered && !deliver())
+			return false;
+		if (!m_count)
+			return false;
+		Request& r = m_requests[m_head];
+		unsigned int start = millis();
+		WilEyeShot shot;
+		shot.id = r.id;
+		shot.ok = 0;
+		shot.failedSetting = apply(r.settings);
+		if (shot.failedSetting < 0)
+		{
+			if (r.op == opPicture)
+				shot.ok = m_io.takePicture(r.destination, r.name) ? 1 : 0;
+			else if (r.op == opStartVideo)
+				shot.ok = m_io.startVideo(r.destination, r.name) ? 1 : 0;
+			else
+				shot.ok = m_io.stopVideo() ? 1 : 0;
+		}
+		shot.blockedMs = millis() - start;
+		m_head = (m_head + 1) % QUEUE;
+		m_count--;
+		if (shot.ok)
+			m_stats.shots++;
+		else
+			m_stats.failures++;
+		m_stats.blockedMs += shot.blockedMs;
+		if (shot.blockedMs > m_stats.maxBlockedMs)
+			m_stats.maxBlockedMs = shot.blockedMs;
+		m_shot = shot;
+		m_undelivered = true;
+		deliver();
+		return true;
+	}
+
+	/// @brief forget the settings believed to be on the camera, call after it reconnects
+	void invalidate()
+	{
+		for (int i = 0; i < wilEyeSettingCount; i++)
+			m_camera[i] = WilEyeSettings::kUnchanged;
+	}
+
+	/// @brief number of requests waiting, plus a completed shot not delivered yet
+	size_t pending() const { return m_count + (m_undelivered ? 1 : 0); }
+
+	WilEyeStats stats() const { return m_stats; }
+
+private:
+	WilEyeCapture(const WilEyeCapture&);
+	WilEyeCapture& operator=(const WilEyeCapture&);
+
+	enum
+	{
+		opPicture = 0,
+		opStartVideo,
+		opStopVideo,
+	};
+
+	struct Request
+	{
+		int id;
+		int op;
+		int destination;
+		WilEyeSettings settings;
+		char name[NAME_LEN];
+	};
+
+	int queue(int op, const WilEyeSettings& settings, int destination, const char* fileName)
+	{
+		if (m_count == QUEUE || strlen(fileName) >= NAME_LEN)
+		{
+			m_stats.rejected++;
+			return -1;
+		}
+		Request& r = m_requests[(m_head + m_count) % QUEUE];
+		r.id = m_nextId++;
+		r.op = op;
+		r.destination = destination;
+		r.settings = settings;
+		strcpy(r.name, fileName);
+		m_count++;
+		m_stats.requests++;
+		return r.id;
+	}
+
+	bool deliver()
+	{
+		if (m_shotFn && !m_shotFn(m_context, m_shot))
+		{
+			m_stats.retries++;
+			return false;
+		}
+		m_undelivered = false;
+		return true;
+	}
+
+	// Returns the setting that failed, or -1 when every change was applied.
+	int apply(const WilEyeSettings& settings)
+	{
+		const int values[wilEyeSettingCount] = { settings.resolution, settings.zoom, settings.contrast, settings.brightness,
+			settings.saturation, settings.hue, settings.flash };
+		for (int i = 0; i < wilEyeSettingCount; i++)
+		{
+			int v = values[i];
+			if (v == WilEyeSettings::kUnchanged)
+				continue;
+			if (v == m_camera[i])
+			{
+				m_stats.settingsSkipped++;
+				continue;
+			}
+			m_stats.settingCalls++;
+			if (!m_io.setting[i](v))
+			{
+				// the camera may be in any state now
+				invalidate();
+				return i;
+			}
+			m_camera[i] = v;
+		}
+		return -1;
+	}
+
+	WilEyeIO m_io;
+	size_t m_head;
+	size_t m_count;
+	int m_nextId;
+	WilEyeShotFn m_shotFn;
+	void* m_context;
+	WilEyeShot m_shot;
+	bool m_undelivered;
+	int m_camera[wilEyeSettingCount];
+	WilEyeStats m_stats;
+	Request m_requests[QUEUE];
+};
+
+} // namespace fwwasm
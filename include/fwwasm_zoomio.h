@@ -0,0 +1,310 @@
+/**
+@file
+	@brief Free-Wili wasm ZoomIO script templates
+runZoomIOScript() takes the whole script as text every call. ZoomIOScripts compiles a script template once into a
+handle: the template is checked, split into literal and parameter segments, and run() only substitutes parameters and
+re-renders when they change, so a fixture toggling the same I/O pattern in a loop does no string work at all.
+
+Templates are ZoomIO text with parameters: `$0` to `$7` insert a parameter in decimal, `$x0` to `$x7` in hex and `$$`
+inserts a literal `$`. FWWASM_ZOOMIO() checks a literal template at compile time:
+
+@code
+static fwwasm::ZoomIOScripts<> zoom;
+static const int kPulse = zoom.compile(FWWASM_ZOOMIO("...$0...$x1..."));
+int params[] = { 25, 0x80 };
+zoom.run(kPulse, params, 2);
+@endcode
+*/
+#pragma once
+
+#include "fwwasm.h"
+
+#include <stddef.h>
+#include <string.h>
+
+#ifndef FWWASM_ZOOMIO_SCRIPT_MAX
+/// @brief the longest rendered script including the terminator
+#define FWWASM_ZOOMIO_SCRIPT_MAX 256
+#endif
+
+/**
+ * @brief a template literal checked at compile time, fails the build with "invalid ZoomIO script template" otherwise
+ */
+#define FWWASM_ZOOMIO(text) \
+	([]() { \
+		static_assert(fwwasm::zoomIOValidate(text) == fwwasm::zoomIOOk, "invalid ZoomIO script template"); \
+		return text; \
+	}())
+
+namespace fwwasm
+{
+
+/**
+ * @brief result of validating a ZoomIO script template
+ */
+typedef enum _ZoomIOTemplateError
+{
+	zoomIOOk = 0,
+	zoomIOBadParameter,	 ///< `$` not followed by `$`, a digit 0-7 or `x` and a digit 0-7
+	zoomIOBadCharacter,	 ///< a control character other than tab, CR or LF
+	zoomIOTooLong,		 ///< the template alone does not fit in FWWASM_ZOOMIO_SCRIPT_MAX
+	zoomIOTooManySegments ///< more than ZOOMIO_SEGMENTS_MAX literal and parameter segments
+} ZoomIOTemplateError;
+
+/// @brief the most segments a template may split into
+static const size_t ZOOMIO_SEGMENTS_MAX = 32;
+
+/// @brief the number of parameters a template may use
+static const int ZOOMIO_PARAMS_MAX = 8;
+
+/**
+ * @brief check a script template
+ * @param text the template
+ * @return zoomIOOk or the first problem found
+ */
+constexpr ZoomIOTemplateError zoomIOValidate(const char* text)
+{
+	size_t i = 0;
+	size_t segments = 0;
+	bool inLiteral = false;
+	for (; text[i]; i++)
+	{
+		char c = text[i];
+		if (static_cast<unsigned char>(c) < 0x20 && c != '\t' && c != '\r' && c != '\n')
+			return zoomIOBadCharacter;
+		if (c != '$')
+		{
+			if (!inLiteral)
+				segments++;
+			inLiteral = true;
+			continue;
+		}
+		// "$$" and each parameter are segments of their own
+		inLiteral = false;
+		segments++;
+		if (text[i + 1] == '$')
+		{
+			i++;
+			continue;
+		}
+		size_t digit = text[i + 1] == 'x' ? i + 2 : i + 1;
+		if (text[digit] < '0' || text[digit] >= '0' + ZOOMIO_PARAMS_MAX)
+			return zoomIOBadParameter;
+		i = digit;
+	}
+	if (i >= FWWASM_ZOOMIO_SCRIPT_MAX)
+		return zoomIOTooLong;
+	if (segments > ZOOMIO_SEGMENTS_MAX)
+		return zoomIOTooManySegments;
+	return zoomIOOk;
+}
+
+/**
+ * @brief signature of the script runner, matches runZoomIOScript()
+ */
+typedef int (*ZoomIORunFn)(const char* szScript);
+
+/**
+ * @brief counters kept by ZoomIOScripts
+ */
+struct ZoomIOStats
+{
+	unsigned int compiled; ///< templates accepted by compile()
+	unsigned int rejected; ///< templates refused by compile()
+	unsigned int runs;	   ///< runZoomIOScript() calls made
+	unsigned int renders;  ///< runs that had to substitute parameters
+	unsigned int errors;   ///< runs refused for a bad handle or a script that did not fit
+};
+
+/**
+ * @brief compiled ZoomIO script templates addressed by handle.
+ * @tparam SCRIPTS the number of templates held
+ */
+template <size_t SCRIPTS = 8>
+class ZoomIOScripts
+{
+public:
+	/// @brief returned by compile() for a rejected template
+	static const int kInvalid = -1;
+
+	/**
+	 * @brief create an empty script table
+	 * @param runFn the script runner, runZoomIOScript() unless a host stand-in is substituted
+	 */
+	explicit ZoomIOScripts(ZoomIORunFn runFn = runZoomIOScript) : m_runFn(runFn), m_count(0), m_lastError(zoomIOOk)
+	{
+		memset(&m_stats, 0, sizeof(m_stats));
+	}
+
+	/**
+	 * @brief compile a template; the text is not copied and must outlive the table
+	 * @param text the template, wrap literals in FWWASM_ZOOMIO() to check them at build time
+	 * @return a handle for run(), or kInvalid, see lastError()
+	 */
+	int compile(const char* text)
+	{
+		m_lastError = zoomIOValidate(text);
+		if (m_lastError != zoomIOOk || m_count == SCRIPTS)
+		{
+			m_stats.rejected++;
+			return kInvalid;
+		}
+		Script& s = m_scripts[m_count];
+		s.text = text;
+		s.segmentCount = 0;
+		s.params = 0;
+		s.rendered = false;
+		for (size_t i = 0; text[i];)
+		{
+			Segment& seg = s.segments[s.segmentCount++];
+			seg.offset = static_cast<unsigned short>(i);
+			seg.param = -1;
+			seg.hex = false;
+			if (text[i] != '$')
+			{
+				while (text[i] && text[i] != '$')
+					i++;
+				seg.length = static_cast<unsigned short>(i - seg.offset);
+			}
+			else if (text[i + 1] == '$')
+			{
+				seg.length = 1;
+				i += 2;
+			}
+			else
+			{
+				seg.hex = text[i + 1] == 'x';
+				i += seg.hex ? 2 : 1;
+				seg.param = static_cast<signed char>(text[i] - '0');
+				seg.length = 0;
+				if (seg.param + 1 > s.params)
+					s.params = seg.param + 1;
+				i++;
+			}
+		}
+		m_stats.compiled++;
+		return static_cast<int>(m_count++);
+	}
+
+	/// @brief why the last compile() failed
+	ZoomIOTemplateError lastError() const { return m_lastError; }
+
+	/// @brief the number of parameters a compiled template uses
+	int parameterCount(int handle) const { return valid(handle) ? m_scripts[handle].params : 0; }
+
+	/**
+	 * @brief substitute parameters and run a compiled script
+	 * @param handle a handle returned by compile()
+	 * @param params the parameter values, missing parameters are 0
+	 * @param count the number of values in params
+	 * @return the runZoomIOScript() result, or -1 if the handle is bad or the script does not fit
+	 */
+	int run(int handle, const int* params = nullptr, size_t count = 0)
+	{
+		if (!valid(handle))
+		{
+			m_stats.errors++;
+			return -1;
+		}
+		Script& s = m_scripts[handle];
+		int values[ZOOMIO_PARAMS_MAX];
+		for (int i = 0; i < ZOOMIO_PARAMS_MAX; i++)
+			values[i] = static_cast<size_t>(i) < count ? params[i] : 0;
+		if (!s.rendered || memcmp(values, s.values, sizeof(int) * static_cast<size_t>(s.params)) != 0)
+		{
+			if (!render(s, values))
+			{
+				m_stats.errors++;
+				return -1;
+			}
+			memcpy(s.values, values, sizeof(values));
+			s.rendered = true;
+			m_stats.renders++;
+		}
+		m_stats.runs++;
+		return m_runFn(s.out);
+	}
+
+	/// @brief the text the last run() of a handle sent, for logging
+	const char* rendered(int handle) const { return valid(handle) && m_scripts[handle].rendered ? m_scripts[handle].out : ""; }
+
+	ZoomIOStats stats() const { return m_stats; }
+
+private:
+	ZoomIOScripts(const ZoomIOScripts&);
+	ZoomIOScripts& operator=(const ZoomIOScripts&);
+
+	struct Segment
+	{
+		unsigned short offset;
+		unsigned short length;
+		signed char param; ///< -1 for literal text
+		bool hex;
+	};
+
+	struct Script
+	{
+		const char* text;
+		Segment segments[ZOOMIO_SEGMENTS_MAX];
+		size_t segmentCount;
+		int params;
+		bool rendered;
+		int values[ZOOMIO_PARAMS_MAX];
+		char out[FWWASM_ZOOMIO_SCRIPT_MAX];
+	};
+
+	bool valid(int handle) const { return handle >= 0 && static_cast<size_t>(handle) < m_count; }
+
+	static bool render(Script& s, const int* values)
+	{
+		size_t used = 0;
+		for (size_t i = 0; i < s.segmentCount; i++)
+		{
+			const Segment& seg = s.segments[i];
+			char digits[12];
+			const char* src = s.text + seg.offset;
+			size_t length = seg.length;
+			if (seg.param >= 0)
+			{
+				length = toText(digits, values[seg.param], seg.hex);
+				src = digits;
+			}
+			if (used + length >= FWWASM_ZOOMIO_SCRIPT_MAX)
+				return false;
+			memcpy(s.out + used, src, length);
+			used += length;
+		}
+		s.out[used] = 0;
+		return true;
+	}
+
+	static size_t toText(char* out, int value, bool hex)
+	{
+		char tmp[12];
+		size_t n = 0;
+		unsigned int v = static_cast<unsigned int>(value);
+		bool negative = !hex && value < 0;
+		if (negative)
+			v = 0u - v;
+		unsigned int base = hex ? 16 : 10;
+		do
+		{
+			tmp[n++] = "0123456789ABCDEF"[v % base];
+			v /= base;
+		} while (v);
+		size_t length = 0;
+		if (negative)
+			out[length++] = '-';
+		while (n)
+			out[length++] = tmp[--n];
+		return length;
+	}
+
+	ZoomIORunFn m_runFn;
+	size_t m_count;
+	ZoomIOTemplateError m_lastError;
+	ZoomIOStats m_stats;
+	Script m_scripts[SCRIPTS];
+};
+
+} // namespace fwwasm
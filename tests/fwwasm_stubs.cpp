@@ -0,0 +1,83 @@
+// Host stand-ins for the imports the helpers bind by default. They are weak so a test can replace any of them with
+// its own definition.
+
+#include "fwwasm_test.h"
+
+#define FWWASM_STUB __attribute__((weak))
+
+namespace fwwasm_test
+{
+unsigned int now = 0;
+}
+
+extern "C"
+{
+
+FWWASM_STUB void waitms(int milliseconds)
+{
+	fwwasm_test::now += static_cast<unsigned int>(milliseconds);
+}
+
+FWWASM_STUB int wilirand(void)
+{
+	static unsigned int state = 0x2545f491u;
+	state = state * 1664525u + 1013904223u;
+	return static_cast<int>(state >> 1);
+}
+
+FWWASM_STUB unsigned int millis(void)
+{
+	return fwwasm_test::now;
+}
+
+FWWASM_STUB int writeFile(int, unsigned char*, int data_bytes)
+{
+	return data_bytes;
+}
+
+FWWASM_STUB int readFile(int, unsigned char*, int* data_bytes)
+{
+	*data_bytes = 0;
+	return 0;
+}
+
+FWWASM_STUB int setFilePosition(int, int)
+{
+	return 1;
+}
+
+FWWASM_STUB int getFileSize(int)
+{
+	return 0;
+}
+
+FWWASM_STUB int preAllocateSpaceForFile(int, int)
+{
+	return 1;
+}
+
+FWWASM_STUB int hasEvent(void)
+{
+	return 0;
+}
+
+FWWASM_STUB int getEventData(unsigned char*)
+{
+	return -1;
+}
+
+FWWASM_STUB void setBoardLED(int, int, int, int, int, LEDManagerLEDMode) {}
+
+FWWASM_STUB void printInt(const char*, printOutColor, printOutDataType, int) {}
+
+FWWASM_STUB void setLogDataText(int, const char*) {}
+
+FWWASM_STUB void setControlValue(int, int, int) {}
+
+FWWASM_STUB void setControlValueFloat(int, int, float) {}
+
+FWWASM_STUB void setControlValueText(int, int, const char*) {}
+
+FWWASM_STUB void setControlProperty(int, int, controlProperty, int) {}
+
+} // extern "C"
@@ -0,0 +1,58 @@
+// Check and timing helpers shared by the host stand-in tests.
+//
+// Each test is a plain main() that runs its scenarios with FWWASM_CHECK() and returns fwwasm_test::result(). The
+// imports a helper binds by default come from fwwasm_stubs.cpp; a test that needs its own behaviour defines the
+// import itself, or passes a stand-in through the helper's IO struct.
+
+#pragma once
+
+#include "fwwasm.h"
+
+#include <chrono>
+#include <stdio.h>
+
+namespace fwwasm_test
+{
+
+/// @brief value returned by the millis() stand-in, advanced by the test
+extern unsigned int now;
+
+/// @brief number of failed checks so far
+inline int& failures()
+{
+	static int count = 0;
+	return count;
+}
+
+/// @brief print the outcome and return the process exit code
+inline int result(const char* name)
+{
+	if (failures())
+		printf("%s: %d checks failed\n", name, failures());
+	else
+		printf("%s: ok\n", name);
+	return failures() ? 1 : 0;
+}
+
+/// @brief nanoseconds per call of fn, run count times
+template <typename FN>
+double nsPerCall(unsigned int count, FN fn)
+{
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	for (unsigned int i = 0; i < count; i++)
+		fn(i);
+	std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - start;
+	return elapsed.count() / count;
+}
+
+} // namespace fwwasm_test
+
+#define FWWASM_CHECK(cond)                                                                \
+	do                                                                                    \
+	{                                                                                     \
+		if (!(cond))                                                                      \
+		{                                                                                 \
+			fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #cond);      \
+			fwwasm_test::failures()++;                                                    \
+		}                                                                                 \
+	} while (0)
@@ -0,0 +1,117 @@
+// AccelFusion against closed-form expectations: a board tilting slowly with a known bias, then vibrating at 5 Hz with
+// noise, must read back its pitch and keep the tilt out of the vibration RMS. The calibration and RMS kernels are
+// checked against scalar references at every batch length so the -msimd128 build (test_accel_simd128) exercises the
+// SIMD128 blocks and tails, and each stage is timed.
+
+#include "fwwasm_accel.h"
+#include "fwwasm_test.h"
+
+static bool near(float a, float b, float tolerance)
+{
+	return fabsf(a - b) <= tolerance;
+}
+
+int main()
+{
+	// kernels against the scalar formulas for lengths 0..32
+	fwwasm::AccelCalibration cal = { { 0.1f, -0.2f, 0.05f }, { 1.02f, 0.01f, 0, -0.01f, 0.98f, 0.02f, 0, 0.03f, 1.01f } };
+	bool same = true;
+	for (size_t count = 0; count <= 32; count++)
+	{
+		float x[32], y[32], z[32], rx[32], ry[32], rz[32];
+		for (size_t i = 0; i < count; i++)
+		{
+			x[i] = 0.01f * static_cast<float>(i);
+			y[i] = 0.5f - 0.02f * static_cast<float>(i);
+			z[i] = 1.0f + 0.005f * static_cast<float>(i);
+			float vx = x[i] - cal.bias[0], vy = y[i] - cal.bias[1], vz = z[i] - cal.bias[2];
+			rx[i] = cal.matrix[0] * vx + cal.matrix[1] * vy + cal.matrix[2] * vz;
+			ry[i] = cal.matrix[3] * vx + cal.matrix[4] * vy + cal.matrix[5] * vz;
+			rz[i] = cal.matrix[6] * vx + cal.matrix[7] * vy + cal.matrix[8] * vz;
+		}
+		fwwasm::accelCalibrate(x, y, z, count, cal);
+		float sum = 0;
+		for (size_t i = 0; i < count; i++)
+		{
+			same = same && near(x[i], rx[i], 1e-5f) && near(y[i], ry[i], 1e-5f) && near(z[i], rz[i], 1e-5f);
+			sum += x[i] * x[i] + y[i] * y[i] + z[i] * z[i];
+		}
+		float zero[32] = {};
+		same = same && near(fwwasm::accelSumSquares(x, y, z, zero, zero, zero, count), sum, 1e-4f * (sum + 1));
+	}
+	FWWASM_CHECK(same);
+
+	// 100 Hz samples: the board tilts slowly from level to 30 degrees of pitch over 10 s, then holds while a 5 Hz, 0.1
+	// amplitude vibration runs on z, above the 2 Hz gravity cutoff; uniform +-0.01 noise on every axis and a 0.05 z bias
+	fwwasm::AccelBatch<32> batch;
+	fwwasm::AccelFusion<32> fusion(2.0f, 10);
+	fwwasm::AccelCalibration bias = fwwasm::AccelCalibration::identity();
+	bias.bias[2] = 0.05f;
+	fusion.setCalibration(bias);
+	const float rad = 3.14159265f / 180;
+	unsigned int seed = 1;
+	auto noise = [&seed]() {
+		seed = seed * 1103515245u + 12345u;
+		return static_cast<float>(seed >> 16 & 0x7FFF) / 32767.0f * 0.02f - 0.01f;
+	};
+	float tiltRms = 0, vibRms = 0, holdPitch = 0;
+	int tiltBatches = 0, vibBatches = 0;
+	for (int n = 0; n < 4000; n++)
+	{
+		float t = static_cast<float>(n) * 0.01f;
+		float pitch = (t < 10 ? t * 3 : 30) * rad;
+		float vibration = t < 10 ? 0 : 0.1f * sinf(2 * 3.14159265f * 5 * t);
+		if (batch.push(-sinf(pitch) + noise(), noise(), cosf(pitch) + 0.05f + vibration + noise()))
+		{
+			fusion.process(batch);
+			batch.clear();
+			// skip the first second of each phase while the filter settles
+			if (t > 1 && t < 10)
+			{
+				tiltRms += fusion.vibrationRms();
+				tiltBatches++;
+			}
+			else if (t > 11)
+			{
+				vibRms += fusion.vibrationRms();
+				holdPitch += fusion.pitch();
+				vibBatches++;
+			}
+		}
+	}
+	tiltRms /= static_cast<float>(tiltBatches);
+	vibRms /= static_cast<float>(vibBatches);
+	holdPitch /= static_cast<float>(vibBatches);
+	FWWASM_CHECK(fusion.samples() == 4000 - 4000 % 32);
+	// a 0.3 degree/s tilt is orientation, not motion: only the noise is left as vibration
+	FWWASM_CHECK(tiltRms < 0.02f);
+	// the 5 Hz sine has RMS 0.0707 and the high-pass complement of a 2 Hz pole passes about 0.93 of it
+	FWWASM_CHECK(vibRms > 0.058f && vibRms < 0.075f);
+	FWWASM_CHECK(near(holdPitch, 30, 1.0f));
+	FWWASM_CHECK(near(fusion.roll(), 0, 1.0f));
+	printf("tilt phase rms %.4f, vibration phase rms %.4f, pitch %.2f roll %.2f\n", tiltRms, vibRms, holdPitch, fusion.roll());
+
+	// per stage cost over a 32 sample batch; the low-pass and tilt are process() minus the two kernels it calls
+	const unsigned int rounds = 100000;
+	fwwasm::AccelCalibration identity = fwwasm::AccelCalibration::identity();
+	fwwasm::AccelFusion<32> timed(2.0f, 10);
+	for (int k = 0; k < 32; k++)
+		batch.push(0.01f * static_cast<float>(k), 0.1f, 1.0f);
+	volatile float sink;
+	double calibrateNs = fwwasm_test::nsPerCall(rounds, [&](unsigned int) {
+		fwwasm::accelCalibrate(batch.x, batch.y, batch.z, batch.count, identity);
+		sink = batch.z[31];
+	});
+	double sumNs = fwwasm_test::nsPerCall(rounds, [&](unsigned int) {
+		sink = fwwasm::accelSumSquares(batch.x, batch.y, batch.z, timed.gravityX(), timed.gravityY(), timed.gravityZ(), batch.count);
+	});
+	double processNs = fwwasm_test::nsPerCall(rounds, [&](unsigned int) {
+		timed.process(batch);
+		sink = timed.vibrationRms();
+	});
+	(void)sink;
+	double filterNs = processNs - calibrateNs - sumNs;
+	printf("32 sample batch: calibrate %.0f, low-pass %.0f, sumSquares %.0f M samples/s; process %.1f ns (%.2f ns per sample)\n",
+		32000 / calibrateNs, 32000 / (filterNs > 0 ? filterNs : processNs), 32000 / sumNs, processNs, processNs / 32);
+	return fwwasm_test::result("test_accel");
+}
@@ -0,0 +1,175 @@
+// FrameArena, FixedPool and ObjectPool behaviour, allocation cost against malloc()/free(), and the peak memory of a long
+// mixed-size session served by an arena and a pool compared with the same session through malloc().
+
+#include "fwwasm_alloc.h"
+#include "fwwasm_test.h"
+
+#include <stdlib.h>
+#if defined(__GLIBC__)
+#include <malloc.h>
+#endif
+
+struct Record
+{
+	int type;
+	unsigned char data[FW_GET_EVENT_DATA_MAX];
+	explicit Record(int t) : type(t) {}
+};
+
+static void testArena()
+{
+	static fwwasm::FrameArena<256> arena;
+	void* a = arena.allocate(3, 1);
+	void* b = arena.allocate(8, 8);
+	FWWASM_CHECK(a && b);
+	FWWASM_CHECK(reinterpret_cast<uintptr_t>(b) % 8 == 0);
+	size_t mark = arena.mark();
+	FWWASM_CHECK(arena.copyString("scoped") != nullptr);
+	arena.rewind(mark);
+	FWWASM_CHECK(arena.mark() == mark);
+	FWWASM_CHECK(arena.allocate(1024) == nullptr);
+	FWWASM_CHECK(arena.stats().failures == 1);
+	arena.reset();
+	FWWASM_CHECK(arena.stats().inUse == 0);
+	FWWASM_CHECK(arena.stats().highWater >= mark);
+	int* zeros = arena.allocArray<int>(8);
+	FWWASM_CHECK(zeros && zeros[0] == 0 && zeros[7] == 0);
+}
+
+static void testPools()
+{
+	static fwwasm::FixedPool<40, 8> pool;
+	void* blocks[9];
+	for (int i = 0; i < 9; i++)
+		blocks[i] = pool.allocate();
+	FWWASM_CHECK(blocks[7] != nullptr);
+	FWWASM_CHECK(blocks[8] == nullptr);
+	FWWASM_CHECK(pool.stats().failures == 1);
+	FWWASM_CHECK(pool.stats().highWater == 8);
+	for (int i = 0; i < 8; i++)
+	{
+		FWWASM_CHECK(pool.owns(blocks[i]));
+		pool.release(blocks[i]);
+	}
+	FWWASM_CHECK(pool.available() == 8);
+
+	static fwwasm::ObjectPool<Record, 4> records;
+	Record* r = records.create(5);
+	FWWASM_CHECK(r && r->type == 5);
+	FWWASM_CHECK(records.available() == 3);
+	records.destroy(r);
+	FWWASM_CHECK(records.available() == 4);
+}
+
+static void benchmark()
+{
+	static fwwasm::FixedPool<64, 32> pool;
+	static fwwasm::FrameArena<4096> arena;
+	void* volatile sink;
+	const unsigned int count = 1000000;
+	double poolNs = fwwasm_test::nsPerCall(count, [&](unsigned int) {
+		void* p = pool.allocate();
+		sink = p;
+		pool.release(p);
+	});
+	double arenaNs = fwwasm_test::nsPerCall(count, [&](unsigned int i) {
+		if ((i & 31) == 0)
+			arena.reset();
+		sink = arena.allocate(64);
+	});
+	double mallocNs = fwwasm_test::nsPerCall(count, [&](unsigned int) {
+		void* p = malloc(64);
+		sink = p;
+		free(p);
+	});
+	(void)sink;
+	printf("64 byte block: pool %.1f ns, arena %.1f ns, malloc/free %.1f ns\n", poolNs, arenaNs, mallocNs);
+}
+
+// bytes malloc() counts as allocated, which includes block headers and freed blocks parked in its caches, and the heap
+// it holds from the system; 0 where the C library cannot be asked
+static size_t heapInUse()
+{
+#if defined(__GLIBC__)
+	return mallinfo2().uordblks;
+#else
+	return 0;
+#endif
+}
+
+static size_t heapReserved()
+{
+#if defined(__GLIBC__)
+	struct mallinfo2 info = mallinfo2();
+	return info.arena + info.hblkhd;
+#else
+	return 0;
+#endif
+}
+
+// Per frame: up to 12 temporaries of 16-512 bytes that die at the end of the frame, and 0-2 messages of 24-64 bytes kept
+// in a ring of 32 until replaced. The arena and pool run the session in fixed storage; malloc() runs the identical one.
+static void footprint()
+{
+	const unsigned int kFrames = 200000;
+	static fwwasm::FrameArena<8192> frame;
+	static fwwasm::FixedPool<64, 32> messages;
+	void* ring[32] = {};
+	void* mallocRing[32] = {};
+	void* temporaries[12];
+	size_t mallocRingBytes[32] = {};
+	size_t live = 0, peakLive = 0, heapBase = heapInUse(), peakHeap = 0, peakReserved = 0;
+	unsigned int seed = 11, slot = 0, failures = 0;
+	for (unsigned int f = 0; f < kFrames; f++)
+	{
+		frame.reset();
+		seed = seed * 1103515245u + 12345u;
+		unsigned int count = (seed >> 16) % 13;
+		size_t frameBytes = 0;
+		for (unsigned int i = 0; i < count; i++)
+		{
+			seed = seed * 1103515245u + 12345u;
+			size_t bytes = 16 + (seed >> 8) % 497;
+			failures += frame.allocate(bytes) == nullptr;
+			temporaries[i] = malloc(bytes);
+			frameBytes += bytes;
+		}
+		for (unsigned int m = (seed >> 4) % 3; m > 0; m--, slot = (slot + 1) % 32)
+		{
+			seed = seed * 1103515245u + 12345u;
+			size_t bytes = 24 + (seed >> 8) % 41;
+			if (ring[slot])
+				messages.release(ring[slot]);
+			ring[slot] = messages.allocate();
+			failures += ring[slot] == nullptr;
+			free(mallocRing[slot]);
+			live -= mallocRingBytes[slot];
+			mallocRing[slot] = malloc(bytes);
+			mallocRingBytes[slot] = bytes;
+			live += bytes;
+		}
+		peakLive = live + frameBytes > peakLive ? live + frameBytes : peakLive;
+		size_t heap = heapInUse() - heapBase;
+		peakHeap = heap > peakHeap ? heap : peakHeap;
+		peakReserved = heapReserved() > peakReserved ? heapReserved() : peakReserved;
+		for (unsigned int i = 0; i < count; i++)
+			free(temporaries[i]);
+	}
+	for (int i = 0; i < 32; i++)
+		free(mallocRing[i]);
+	FWWASM_CHECK(failures == 0);
+	size_t arenaPeak = frame.stats().highWater;
+	size_t poolPeak = messages.stats().highWater * 64;
+	FWWASM_CHECK(arenaPeak + poolPeak >= peakLive);
+	printf("%u frame session, peak bytes: arena %zu + pool %zu in %zu fixed; malloc %zu requested, %zu held, %zu heap\n",
+		kFrames, arenaPeak, poolPeak, sizeof(frame) + sizeof(messages), peakLive, peakHeap, peakReserved);
+}
+
+int main()
+{
+	testArena();
+	testPools();
+	benchmark();
+	footprint();
+	return fwwasm_test::result("test_alloc");
+}
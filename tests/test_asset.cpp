@@ -0,0 +1,103 @@
+// AssetFile paging against a 64 KB stand-in file, compared with loading the whole file at startup, and PictureCache
+// load/reuse behaviour.
+
+#include "fwwasm_asset.h"
+#include "fwwasm_test.h"
+
+#include <vector>
+
+static std::vector<unsigned char> g_file;
+static size_t g_pos;
+static unsigned int g_loads, g_properties;
+
+extern "C" void addControlPictureFromFile(int, int, int, int, const char*, int)
+{
+	g_loads++;
+}
+
+extern "C" void setControlProperty(int, int, controlProperty, int)
+{
+	g_properties++;
+}
+
+static int fileRead(int, unsigned char* data, int* bytes)
+{
+	int n = 0;
+	while (n < *bytes && g_pos < g_file.size())
+		data[n++] = g_file[g_pos++];
+	*bytes = n;
+	return 1;
+}
+
+static int fileSeek(int, int position)
+{
+	g_pos = static_cast<size_t>(position);
+	return 1;
+}
+
+static int fileSize(int)
+{
+	return static_cast<int>(g_file.size());
+}
+
+static void testAssetFile()
+{
+	g_file.resize(64 * 1024);
+	for (size_t i = 0; i < g_file.size(); i++)
+		g_file[i] = static_cast<unsigned char>(i * 31 + (i >> 8));
+	fwwasm::AssetIO io = { fileRead, fileSeek, fileSize };
+
+	static fwwasm::AssetFile<512, 4> table(io);
+	FWWASM_CHECK(table.open(3));
+	FWWASM_CHECK(table.size() == g_file.size());
+	const unsigned char* w = table.window(1000, 16);
+	FWWASM_CHECK(w && memcmp(w, &g_file[1000], 16) == 0);
+	FWWASM_CHECK(table.window(1020, 8) == nullptr); // crosses a page
+	unsigned char buf[700];
+	FWWASM_CHECK(table.read(900, buf, sizeof(buf)) == sizeof(buf) && memcmp(buf, &g_file[900], sizeof(buf)) == 0);
+	FWWASM_CHECK(table.read(g_file.size() - 10, buf, 100) == 10);
+	unsigned short v;
+	memcpy(&v, &g_file[2 * 1234], sizeof(v));
+	FWWASM_CHECK(table.get<unsigned short>(1234) == v);
+	FWWASM_CHECK(table.get<unsigned short>(1u << 20, 7) == 7);
+
+	// a frame that looks up a few table entries, against reading the whole file before the first panel
+	table.invalidate();
+	fwwasm::AssetStats before = table.stats();
+	for (unsigned int i = 0; i < 16; i++)
+		table.get<unsigned char>((i * 97) % 2048);
+	fwwasm::AssetStats after = table.stats();
+	printf("startup: paged %u bytes in %u reads, %zu bytes of linear memory; whole file %zu bytes\n",
+		after.bytesRead - before.bytesRead, after.readCalls - before.readCalls, sizeof(table), g_file.size());
+	FWWASM_CHECK(sizeof(table) < g_file.size() / 16);
+}
+
+static void testPictureCache()
+{
+	static fwwasm::PictureCache<4, 24> pictures;
+	pictures.show(0, 1, 10, 10, "logo.bmp", 1);
+	pictures.show(0, 1, 10, 10, "logo.bmp", 1);
+	FWWASM_CHECK(g_loads == 1 && g_properties == 0);
+	pictures.show(0, 1, 20, 10, "logo.bmp", 1);
+	FWWASM_CHECK(g_loads == 1 && g_properties == 1);
+	pictures.hide(0, 1);
+	pictures.show(0, 1, 20, 10, "logo.bmp", 1);
+	FWWASM_CHECK(g_loads == 1 && g_properties == 3);
+
+	// keyed per control: a new file reloads, the same file on another control loads into that control
+	pictures.show(0, 1, 20, 10, "warn.bmp", 1);
+	FWWASM_CHECK(g_loads == 2);
+	pictures.show(0, 2, 20, 10, "warn.bmp", 1);
+	FWWASM_CHECK(g_loads == 3);
+	pictures.show(0, 3, 0, 0, "a_name_longer_than_the_cache_keeps.bmp", 1);
+	pictures.show(0, 3, 0, 0, "a_name_longer_than_the_cache_keeps.bmp", 1);
+	FWWASM_CHECK(g_loads == 5);
+	FWWASM_CHECK(pictures.stats().loads == 5 && pictures.stats().reuses == 3);
+}
+
+int main()
+{
+	testAssetFile();
+	testPictureCache();
+	return fwwasm_test::result("test_asset");
+}
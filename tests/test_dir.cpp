@@ -0,0 +1,95 @@
+// DirectoryIndex over a stand-in getDirectoryItemByIndex() that rescans from the first entry on every call, like the
+// firmware. Reports directory reads and time for 10, 100 and 1000 entries: the first screen, a full first listing and
+// the cached listings after it.
+
+#include "fwwasm_dir.h"
+#include "fwwasm_test.h"
+
+#include <stdio.h>
+
+extern "C" int makeDirectory(const char*)
+{
+	return 1;
+}
+
+static unsigned int g_entries;
+static unsigned long g_reads;
+
+static int listEntry(const char*, const char* file_name, int, int index)
+{
+	char* name = const_cast<char*>(file_name);
+	g_reads += static_cast<unsigned long>(index) + 1;
+	if (index < 0 || static_cast<unsigned int>(index) >= g_entries)
+	{
+		name[0] = 0;
+		return 0;
+	}
+	snprintf(name, FWWASM_DIR_NAME_MAX, "rec%04d.wav", index);
+	return 1;
+}
+
+static void benchmark(unsigned int entries)
+{
+	static fwwasm::DirectoryIndex<1024, 1024 * 12> index(listEntry);
+	g_entries = entries;
+	fwwasm::invalidateDirectoryIndexes();
+	FWWASM_CHECK(index.open("/recordings", 1));
+
+	g_reads = 0;
+	for (size_t i = 0; i < 8; i++)
+		index.name(i);
+	unsigned long screenReads = g_reads;
+
+	g_reads = 0;
+	double firstNs = fwwasm_test::nsPerCall(1, [&](unsigned int) { index.size(); });
+	unsigned long firstReads = g_reads;
+	FWWASM_CHECK(index.size() == entries);
+	FWWASM_CHECK(index.complete() && index.cached());
+
+	g_reads = 0;
+	size_t seen = 0;
+	double cachedNs = fwwasm_test::nsPerCall(100, [&](unsigned int) {
+		for (const char* name : index)
+			seen += name[0] == 'r';
+	});
+	FWWASM_CHECK(g_reads == 0);
+	FWWASM_CHECK(seen == 100 * entries);
+	printf("%4u entries: first 8 names %lu reads, full first listing %lu reads %.1f us, cached listing 0 reads %.2f us\n", entries,
+		screenReads, firstReads, firstNs / 1000, cachedNs / 1000);
+}
+
+static void testBehaviour()
+{
+	static fwwasm::DirectoryIndex<16, 16 * 12> index(listEntry);
+	g_entries = 40;
+	fwwasm::invalidateDirectoryIndexes();
+	index.open("/recordings", 1);
+	FWWASM_CHECK(index.find("rec0003.wav") == 3);
+	FWWASM_CHECK(!index.cached());
+	FWWASM_CHECK(index.size() == 16);
+	FWWASM_CHECK(!index.complete());
+
+	g_entries = 5;
+	unsigned int frames = 0;
+	fwwasm::makeDirectory("/recordings/new");
+	while (!index.update(2))
+		frames++;
+	FWWASM_CHECK(frames == 2);
+	FWWASM_CHECK(index.size() == 5 && index.complete());
+	FWWASM_CHECK(index.find("rec0009.wav") == -1);
+	FWWASM_CHECK(index.name(5) == nullptr);
+
+	char longPath[FWWASM_DIR_PATH_MAX + 1];
+	memset(longPath, 'a', sizeof(longPath) - 1);
+	longPath[FWWASM_DIR_PATH_MAX] = 0;
+	FWWASM_CHECK(!index.open(longPath, 1));
+}
+
+int main()
+{
+	testBehaviour();
+	benchmark(10);
+	benchmark(100);
+	benchmark(1000);
+	return fwwasm_test::result("test_dir");
+}
@@ -0,0 +1,210 @@
+// EventQueue overflow scenarios against a stand-in firmware FIFO of 32 events: a sensor flood with button presses, a
+// lane that mixes keep-all and never-drop types, a lane filled with never-drop events only, and WILEye completions
+// posted while firmware events flood the normal lane and the app lane runs full.
+
+#include "fwwasm_events.h"
+#include "fwwasm_test.h"
+#include "fwwasm_wileye.h"
+
+#include <deque>
+#include <stdlib.h>
+
+struct RawEvent
+{
+	int type;
+	unsigned int seq;
+};
+
+static std::deque<RawEvent> g_fifo;
+static unsigned int g_firmwareDropped;
+
+static int fifoHas()
+{
+	return !g_fifo.empty();
+}
+
+static int fifoGet(unsigned char* data)
+{
+	RawEvent r = g_fifo.front();
+	g_fifo.pop_front();
+	memset(data, 0, FW_GET_EVENT_DATA_MAX);
+	memcpy(data, &r.seq, sizeof(r.seq));
+	return r.type;
+}
+
+static void raise(int type, unsigned int seq)
+{
+	if (g_fifo.size() >= 32)
+	{
+		g_firmwareDropped++;
+		return;
+	}
+	RawEvent r = { type, seq };
+	g_fifo.push_back(r);
+}
+
+static unsigned int seqOf(const fwwasm::Event& ev)
+{
+	unsigned int seq;
+	memcpy(&seq, ev.data, sizeof(seq));
+	return seq;
+}
+
+static const fwwasm::EventSource kFifo = { fifoHas, fifoGet };
+
+static void testSensorFlood()
+{
+	g_fifo.clear();
+	g_firmwareDropped = 0;
+	fwwasm::EventQueue<8, 8, 2> events(kFifo);
+	unsigned int sent = 0, got = 0, last = 0;
+	bool ordered = true;
+	srand(2);
+	for (unsigned int frame = 0; frame < 10000; frame++)
+	{
+		for (int i = 0; i < 20; i++)
+			raise(FWGUI_EVENT_GUI_SENSOR_DATA, frame);
+		if (rand() % 3 == 0)
+			raise(FWGUI_EVENT_GREEN_BUTTON, ++sent);
+		fwwasm::Event ev;
+		for (int handled = 0; handled < 3 && events.next(ev); handled++)
+		{
+			if (ev.type != FWGUI_EVENT_GREEN_BUTTON)
+				continue;
+			ordered = ordered && seqOf(ev) == last + 1;
+			last = seqOf(ev);
+			got++;
+		}
+	}
+	fwwasm::EventTypeStats sensor = events.stats(FWGUI_EVENT_GUI_SENSOR_DATA);
+	FWWASM_CHECK(got == sent && ordered);
+	FWWASM_CHECK(g_firmwareDropped == 0);
+	FWWASM_CHECK(events.stats(FWGUI_EVENT_GREEN_BUTTON).dropped == 0);
+	FWWASM_CHECK(sensor.received == sensor.delivered + sensor.coalesced);
+	printf("sensor flood: %u/%u buttons in order, %u sensor events coalesced into %u\n", got, sent, sensor.coalesced,
+		sensor.delivered);
+}
+
+static void testMixedLane()
+{
+	g_fifo.clear();
+	fwwasm::EventQueue<4, 4, 2> events(kFifo);
+	events.setPolicy(FWGUI_EVENT_PANEL_SHOW, fwwasm::eventLaneNormal, fwwasm::eventNeverDrop);
+	unsigned int shows = 0, showsGot = 0;
+	for (unsigned int frame = 0; frame < 200; frame++)
+	{
+		for (unsigned int i = 0; i < 6; i++)
+			raise(FWGUI_EVENT_GUI_I2C_RESPONSE, i);
+		if (frame % 5 == 0)
+			raise(FWGUI_EVENT_PANEL_SHOW, ++shows);
+		fwwasm::Event ev;
+		if (events.next(ev) && ev.type == FWGUI_EVENT_PANEL_SHOW)
+			showsGot++;
+	}
+	fwwasm::Event ev;
+	while (events.next(ev))
+		showsGot += ev.type == FWGUI_EVENT_PANEL_SHOW;
+	FWWASM_CHECK(g_fifo.empty());
+	FWWASM_CHECK(showsGot == shows);
+	FWWASM_CHECK(events.stats(FWGUI_EVENT_PANEL_SHOW).dropped == 0);
+	FWWASM_CHECK(events.stats(FWGUI_EVENT_GUI_I2C_RESPONSE).dropped > 0);
+	printf("mixed lane: %u/%u panel-show events delivered, %u keep-all events dropped\n", showsGot, shows,
+		events.stats(FWGUI_EVENT_GUI_I2C_RESPONSE).dropped);
+}
+
+static void testNeverDropLane()
+{
+	g_fifo.clear();
+	fwwasm::EventQueue<4, 2, 2> events(kFifo);
+	events.setPolicy(FWGUI_EVENT_PANEL_SHOW, fwwasm::eventLaneNormal, fwwasm::eventNeverDrop);
+	raise(FWGUI_EVENT_PANEL_SHOW, 1);
+	raise(FWGUI_EVENT_PANEL_SHOW, 2);
+	raise(FWGUI_EVENT_GUI_I2C_RESPONSE, 3);
+	events.pump();
+	// the lane holds two never-drop events, the keep-all event is the one discarded
+	FWWASM_CHECK(events.stats(FWGUI_EVENT_GUI_I2C_RESPONSE).dropped == 1);
+	FWWASM_CHECK(events.pending() == 2);
+	fwwasm::Event ev;
+	FWWASM_CHECK(events.next(ev) && seqOf(ev) == 1);
+	FWWASM_CHECK(events.next(ev) && seqOf(ev) == 2);
+	FWWASM_CHECK(!events.next(ev));
+}
+
+static int cameraOk(int, const char*)
+{
+	return 1;
+}
+
+static int cameraStop()
+{
+	return 1;
+}
+
+static int cameraSetting(int)
+{
+	return 1;
+}
+
+static void testPostedEvents()
+{
+	g_fifo.clear();
+	fwwasm::WilEyeIO camera = { cameraOk, cameraOk, cameraStop,
+		{ cameraSetting, cameraSetting, cameraSetting, cameraSetting, cameraSetting, cameraSetting, cameraSetting }, nullptr, nullptr };
+	typedef fwwasm::EventQueue<4, 4, 2, 2> Queue;
+	Queue events(kFifo);
+	fwwasm::WilEyeCapture<> eye(camera);
+	eye.onShot(fwwasm::postWilEyeShot<Queue>, &events);
+	unsigned int requested = 0, delivered = 0;
+	int lastId = 0;
+	bool ordered = true;
+	for (unsigned int frame = 0; frame < 400; frame++)
+	{
+		for (unsigned int i = 0; i < 6; i++)
+			raise(FWGUI_EVENT_GUI_I2C_RESPONSE, i);
+		if (eye.capture(fwwasm::WilEyeSettings::unchanged(), 0, "shot.jpg") > 0)
+			requested++;
+		eye.update();
+		// a slow consumer: only every fourth frame handles events, so the app lane runs full in between
+		fwwasm::Event ev;
+		for (int handled = 0; frame % 4 == 0 && handled < 8 && events.next(ev); handled++)
+		{
+			fwwasm::WilEyeShot shot;
+			if (!fwwasm::wilEyeShotFromEvent(ev, shot))
+				continue;
+			ordered = ordered && shot.id == lastId + 1;
+			lastId = shot.id;
+			delivered++;
+		}
+	}
+	for (int i = 0; i < 100 && (eye.pending() || events.pending()); i++)
+	{
+		eye.update();
+		fwwasm::Event ev;
+		while (events.next(ev))
+		{
+			fwwasm::WilEyeShot shot;
+			if (fwwasm::wilEyeShotFromEvent(ev, shot))
+			{
+				ordered = ordered && shot.id == lastId + 1;
+				lastId = shot.id;
+				delivered++;
+			}
+		}
+	}
+	fwwasm::EventTypeStats posted = events.stats(FWWASM_EVENT_WILEYE_SHOT);
+	FWWASM_CHECK(requested > 0 && delivered == requested && ordered);
+	FWWASM_CHECK(eye.stats().retries > 0 && posted.dropped == eye.stats().retries);
+	FWWASM_CHECK(posted.received == requested && posted.delivered == requested);
+	FWWASM_CHECK(events.stats(FWGUI_EVENT_GUI_I2C_RESPONSE).dropped > 0);
+	printf("posted events: %u/%u shots delivered in order, %u posts refused and retried\n", delivered, requested,
+		eye.stats().retries);
+}
+
+int main()
+{
+	testSensorFlood();
+	testMixedLane();
+	testNeverDropLane();
+	testPostedEvents();
+	return fwwasm_test::result("test_events");
+}
@@ -0,0 +1,62 @@
+// Placeholder formatting, including hex/binary width of negative values and the exponent fallback for large floats.
+
+#include "fwwasm_format.h"
+#include "fwwasm_test.h"
+
+#include <string.h>
+
+static char g_line[FWWASM_FORMAT_LINE_MAX];
+
+extern "C" void setLogDataText(int, const char* text)
+{
+	strcpy(g_line, text);
+}
+
+#define CHECK_FORMAT(expected, ...)                                      \
+	do                                                                   \
+	{                                                                    \
+		char buf[64];                                                    \
+		fwwasm::formatTo(buf, sizeof(buf), __VA_ARGS__);                 \
+		if (strcmp(buf, expected) != 0)                                  \
+			fprintf(stderr, "got \"%s\" expected \"%s\"\n", buf, expected); \
+		FWWASM_CHECK(strcmp(buf, expected) == 0);                        \
+	} while (0)
+
+int main()
+{
+	CHECK_FORMAT("x=5 y=-003.142 h=ff", "x={} y={:08.3f} h={:x}", 5, -3.14159f, 255u);
+	CHECK_FORMAT("    ab|cd    |-00042|BEEF|101|true|z", "{:>6}|{:<6}|{:06}|{:X}|{:b}|{}|{}", "ab", "cd", -42, 0xbeefu, 5, true, 'z');
+	CHECK_FORMAT("abc{}", "{:.3}{{}}", "abcdef");
+
+	// negative values keep the width of their own type in hex and binary
+	CHECK_FORMAT("ffffffff", "{:x}", -1);
+	CHECK_FORMAT("FFFE", "{:X}", static_cast<short>(-2));
+	CHECK_FORMAT("11111111", "{:b}", static_cast<signed char>(-1));
+	CHECK_FORMAT("ffffffffffffffff", "{:x}", -1ll);
+	CHECK_FORMAT("-1", "{}", -1);
+
+	// values past 64 bit fixed point use exponent form, real infinities stay inf
+	CHECK_FORMAT("100000000000000000.00", "{}", 1e17);
+	CHECK_FORMAT("1.80e+17", "{}", 1.8e17);
+	CHECK_FORMAT("-2.5e+30", "{:.1f}", -2.5e30);
+	CHECK_FORMAT("1.000e+20", "{:.3}", 9.9999999e19);
+	CHECK_FORMAT("inf -inf nan", "{} {} {}", 1e300 * 1e300, -1e300 * 1e300, (1e300 * 1e300) - (1e300 * 1e300));
+
+	char small[6];
+	fwwasm::FormatBuffer fb(small, sizeof(small));
+	fwwasm::formatTo(fb, "{}", 123456789);
+	FWWASM_CHECK(fb.truncated() && strcmp(small, "12345") == 0);
+
+	// an escaped '%' that does not fit as a pair is dropped whole, and nothing after it is appended
+	fwwasm::FormatBuffer escaped(small, sizeof(small));
+	escaped.setEscapePercent(true);
+	fwwasm::formatTo(escaped, "{}%x", 1234);
+	FWWASM_CHECK(escaped.truncated() && strcmp(small, "1234") == 0);
+	escaped.clear();
+	fwwasm::formatTo(escaped, "{}%", 12);
+	FWWASM_CHECK(!escaped.truncated() && strcmp(small, "12%%") == 0);
+
+	fwwasm::logText(1, "t={}ms", 1234u);
+	FWWASM_CHECK(strcmp(g_line, "t=1234ms") == 0);
+	return fwwasm_test::result("test_format");
+}
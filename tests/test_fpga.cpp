@@ -0,0 +1,203 @@
+// FpgaLoader against a stand-in card and FPGA: a good image is staged and loaded from memory or from another file, and
+// every failure (space, read, write, CRC, load) closes the staging file once and completes a progress dialog driven by
+// fpgaProgressDialog(). Staging throughput is timed for several chunk sizes.
+
+#include "fwwasm_fpga.h"
+#include "fwwasm_test.h"
+
+#include <chrono>
+#include <vector>
+
+static std::vector<unsigned char> g_card;
+static const unsigned char* g_source; // what the source file handle reads from
+static size_t g_sourceSize;
+static size_t g_sourcePos;
+static int g_closes;
+static int g_loads;
+static int g_dialog;
+static bool g_spaceFails;
+static bool g_writeFails;
+static bool g_loadFails;
+
+extern "C" void setProgressDialogValue(int value)
+{
+	g_dialog = value;
+}
+
+static int cardWrite(int, unsigned char* data, int bytes)
+{
+	if (g_writeFails && g_card.size() > 100000)
+		return 0;
+	g_card.insert(g_card.end(), data, data + bytes);
+	return bytes;
+}
+
+static int cardRead(int, unsigned char* data, int* bytes)
+{
+	size_t n = g_sourceSize - g_sourcePos;
+	if (n > static_cast<size_t>(*bytes))
+		n = static_cast<size_t>(*bytes);
+	memcpy(data, g_source + g_sourcePos, n);
+	g_sourcePos += n;
+	*bytes = static_cast<int>(n);
+	return 1;
+}
+
+static int preAllocate(int, int)
+{
+	return g_spaceFails ? 0 : 1;
+}
+
+static int cardClose(int)
+{
+	g_closes++;
+	return 1;
+}
+
+static int fpgaLoad(const char*)
+{
+	g_loads++;
+	return g_loadFails ? 0 : 1;
+}
+
+static void reset()
+{
+	g_card.clear();
+	g_closes = g_loads = 0;
+	g_dialog = -1;
+	g_spaceFails = g_writeFails = g_loadFails = false;
+	g_source = nullptr;
+	g_sourceSize = g_sourcePos = 0;
+}
+
+// stages the image in memory, returns the final state
+template <size_t CHUNK>
+static fwwasm::FpgaLoadState stage(const std::vector<unsigned char>& image, unsigned int crc, fwwasm::FpgaLoader<CHUNK>& fpga)
+{
+	fpga.onProgress(fwwasm::fpgaProgressDialog, nullptr);
+	if (!fpga.beginFromMemory(image.data(), image.size(), 3, "stage.bit", crc, true))
+		return fpga.state();
+	return fpga.run();
+}
+
+// staging throughput from memory and from a file for one chunk size
+template <size_t CHUNK>
+static void timeLoad(const std::vector<unsigned char>& image, unsigned int crc, const fwwasm::FpgaIO& io)
+{
+	const int rounds = 20;
+	double memorySeconds = 0, fileSeconds = 0;
+	unsigned int writes = 0;
+	for (int round = 0; round < rounds; round++)
+	{
+		reset();
+		fwwasm::FpgaLoader<CHUNK> fpga(io);
+		std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+		bool done = stage(image, crc, fpga) == fwwasm::fpgaDone;
+		memorySeconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+		writes = fpga.stats().writeCalls;
+
+		reset();
+		g_source = image.data();
+		g_sourceSize = image.size();
+		fwwasm::FpgaLoader<CHUNK> fromFile(io);
+		start = std::chrono::steady_clock::now();
+		done = done && fromFile.beginFromFile(5, image.size(), 3, "stage.bit", crc, true) && fromFile.run() == fwwasm::fpgaDone;
+		fileSeconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+		FWWASM_CHECK(done);
+	}
+	double megabytes = static_cast<double>(image.size()) * rounds / 1e6;
+	printf("chunk %5zu: %4u writes, %.0f MB/s from memory, %.0f MB/s from a file\n", CHUNK, writes, megabytes / memorySeconds,
+		megabytes / fileSeconds);
+}
+
+int main()
+{
+	std::vector<unsigned char> image(579 * 1024);
+	for (size_t i = 0; i < image.size(); i++)
+		image[i] = static_cast<unsigned char>(i * 7 + i / 300);
+	unsigned int crc = fwwasm::crc32Update(0, image.data(), image.size());
+	fwwasm::FpgaIO io = { cardWrite, cardRead, preAllocate, cardClose, fpgaLoad };
+
+	{
+		reset();
+		fwwasm::FpgaLoader<> fpga(io);
+		FWWASM_CHECK(stage(image, crc, fpga) == fwwasm::fpgaDone);
+		FWWASM_CHECK(g_card == image && g_loads == 1 && g_closes == 1 && g_dialog == 100);
+		printf("%zu byte image: %u writes, %u progress updates\n", image.size(), fpga.stats().writeCalls, fpga.stats().progress);
+	}
+	{
+		// the same image read through another file handle; CHUNK need not divide the size
+		reset();
+		g_source = image.data();
+		g_sourceSize = image.size();
+		fwwasm::FpgaLoader<1000> fpga(io);
+		FWWASM_CHECK(fpga.beginFromFile(5, image.size(), 3, "stage.bit", crc, true));
+		FWWASM_CHECK(fpga.run() == fwwasm::fpgaDone);
+		FWWASM_CHECK(g_card == image && g_sourcePos == image.size() && g_loads == 1 && g_closes == 1);
+		FWWASM_CHECK(fpga.stats().readCalls == (image.size() + 999) / 1000);
+	}
+	{
+		// a source file shorter than announced runs dry and fails with a read error
+		reset();
+		g_source = image.data();
+		g_sourceSize = image.size() / 2;
+		fwwasm::FpgaLoader<> fpga(io);
+		fpga.onProgress(fwwasm::fpgaProgressDialog, nullptr);
+		FWWASM_CHECK(fpga.beginFromFile(5, image.size(), 3, "stage.bit"));
+		FWWASM_CHECK(fpga.run() == fwwasm::fpgaFailed);
+		FWWASM_CHECK(fpga.error() == fwwasm::fpgaReadError && g_loads == 0 && g_closes == 1 && g_dialog == 100);
+	}
+	{
+		// without checkCrc the default CRC argument does not refuse a good image
+		reset();
+		fwwasm::FpgaLoader<> fpga(io);
+		FWWASM_CHECK(fpga.beginFromMemory(image.data(), image.size(), 3, "stage.bit"));
+		FWWASM_CHECK(fpga.run() == fwwasm::fpgaDone && g_loads == 1);
+	}
+	{
+		reset();
+		g_spaceFails = true;
+		fwwasm::FpgaLoader<> fpga(io);
+		FWWASM_CHECK(stage(image, crc, fpga) == fwwasm::fpgaFailed);
+		FWWASM_CHECK(fpga.error() == fwwasm::fpgaSpaceError);
+		FWWASM_CHECK(g_card.empty() && g_loads == 0 && g_closes == 1 && g_dialog == 100);
+	}
+	{
+		reset();
+		g_writeFails = true;
+		fwwasm::FpgaLoader<> fpga(io);
+		FWWASM_CHECK(stage(image, crc, fpga) == fwwasm::fpgaFailed);
+		FWWASM_CHECK(fpga.error() == fwwasm::fpgaWriteError);
+		FWWASM_CHECK(g_loads == 0 && g_closes == 1 && g_dialog == 100);
+	}
+	{
+		reset();
+		fwwasm::FpgaLoader<> fpga(io);
+		FWWASM_CHECK(stage(image, crc ^ 1, fpga) == fwwasm::fpgaFailed);
+		FWWASM_CHECK(fpga.error() == fwwasm::fpgaCrcError);
+		FWWASM_CHECK(g_loads == 0 && g_closes == 1 && g_dialog == 100);
+	}
+	{
+		reset();
+		g_loadFails = true;
+		fwwasm::FpgaLoader<> fpga(io);
+		FWWASM_CHECK(stage(image, crc, fpga) == fwwasm::fpgaFailed);
+		FWWASM_CHECK(fpga.error() == fwwasm::fpgaLoadError);
+		FWWASM_CHECK(g_loads == 1 && g_closes == 1 && g_dialog == 100);
+	}
+	{
+		// a stream announced shorter than what arrives fails on the write that overruns it
+		reset();
+		fwwasm::FpgaLoader<> fpga(io);
+		fpga.onProgress(fwwasm::fpgaProgressDialog, nullptr);
+		FWWASM_CHECK(fpga.beginStream(1000, 3, "stage.bit", 0, false));
+		FWWASM_CHECK(!fpga.write(image.data(), 1001));
+		FWWASM_CHECK(fpga.error() == fwwasm::fpgaSizeError && g_closes == 1 && g_dialog == 100);
+	}
+
+	timeLoad<512>(image, crc, io);
+	timeLoad<1024>(image, crc, io);
+	timeLoad<4096>(image, crc, io);
+	timeLoad<16384>(image, crc, io);
+	return fwwasm_test::result("test_fpga");
+}
@@ -0,0 +1,69 @@
+// LedPlayer against a stand-in setBoardLED() that tracks until when each LED stays lit: a steady LED in a looping
+// animation must never go dark, and unchanged colors must not be resent every frame.
+
+#include "fwwasm_led.h"
+#include "fwwasm_test.h"
+
+static unsigned int g_litUntil[7];
+static unsigned int g_color[7];
+static unsigned int g_calls;
+
+static void boardLed(int led, int r, int g, int b, int duration_ms, LEDManagerLEDMode)
+{
+	g_litUntil[led] = fwwasm_test::now + static_cast<unsigned int>(duration_ms);
+	g_color[led] = static_cast<unsigned int>(r << 16 | g << 8 | b);
+	g_calls++;
+}
+
+static bool lit(int led)
+{
+	return static_cast<int>(g_litUntil[led] - fwwasm_test::now) > 0;
+}
+
+static void complete(void* context)
+{
+	*static_cast<bool*>(context) = true;
+}
+
+int main()
+{
+	static const fwwasm::LedKeyframe kLoop[] = {
+		{ 0, 0, 255, 0, 0, fwwasm::ledStep },
+		{ 0, 1, 0, 0, 0, fwwasm::ledLinear },
+		{ 300, 1, 0, 0, 255, fwwasm::ledLinear },
+		{ 599, 1, 0, 0, 0, fwwasm::ledStep },
+	};
+	fwwasm::LedPlayer<> leds(20, boardLed);
+	fwwasm_test::now = 1000;
+	leds.play(kLoop, 4, 600, true, fwwasm_test::now);
+	bool steady = true;
+	unsigned int led0Calls = 0;
+	for (unsigned int step = 0; step < 2000; step++)
+	{
+		fwwasm_test::now += 5;
+		unsigned int before = g_calls;
+		leds.update(fwwasm_test::now);
+		if (g_calls != before && g_litUntil[0] == fwwasm_test::now + 600 + 40)
+			led0Calls++;
+		steady = steady && lit(0) && g_color[0] == 0xFF0000;
+	}
+	FWWASM_CHECK(steady);
+	// one renewal per period for the steady LED, not one per frame
+	FWWASM_CHECK(led0Calls >= 15 && led0Calls <= 18);
+	FWWASM_CHECK(leds.stats().calls < leds.stats().frames * 2);
+	printf("10 s of a 600 ms loop: %u frames, %u setBoardLED() calls, steady LED renewed %u times\n", leds.stats().frames,
+		leds.stats().calls, led0Calls);
+
+	// a one-shot animation holds its last colors to the end and reports completion
+	bool done = false;
+	leds.onComplete(complete, &done);
+	leds.play(kLoop, 4, 600, false, fwwasm_test::now);
+	for (unsigned int step = 0; step < 200 && leds.playing(); step++)
+	{
+		fwwasm_test::now += 5;
+		leds.update(fwwasm_test::now);
+		FWWASM_CHECK(lit(0));
+	}
+	FWWASM_CHECK(done && !leds.playing());
+	return fwwasm_test::result("test_led");
+}
@@ -0,0 +1,112 @@
+// LogFeeder against a stand-in setLogDataText(): both overflow policies keep the lines they promise, consecutive repeats
+// are folded into one line with a count, pump() never exceeds the per frame limit, and the mirror file sees every line.
+
+#include "fwwasm_log.h"
+#include "fwwasm_test.h"
+
+#include <string>
+#include <vector>
+
+static std::vector<std::string> g_shown;
+static std::string g_mirror;
+
+static void showLine(int, const char* text)
+{
+	g_shown.push_back(text);
+}
+
+static int mirrorWrite(int, unsigned char* data, int bytes)
+{
+	g_mirror.append(reinterpret_cast<const char*>(data), static_cast<size_t>(bytes));
+	return bytes;
+}
+
+static void testOverflow()
+{
+	g_shown.clear();
+	fwwasm::LogFeeder<4> oldest(0, 0, fwwasm::logDropOldest, showLine);
+	for (int i = 0; i < 10; i++)
+		oldest.pushf("line {}", i);
+	oldest.pump();
+	FWWASM_CHECK(g_shown.size() == 4 && g_shown[0] == "line 6" && g_shown[3] == "line 9");
+	FWWASM_CHECK(oldest.stats().dropped == 6 && oldest.stats().highWater == 4);
+
+	g_shown.clear();
+	fwwasm::LogFeeder<4> newest(0, 0, fwwasm::logDropNewest, showLine);
+	bool accepted = true;
+	for (int i = 0; i < 10; i++)
+		accepted = newest.pushf("line {}", i) && accepted;
+	newest.pump();
+	FWWASM_CHECK(!accepted);
+	FWWASM_CHECK(g_shown.size() == 4 && g_shown[0] == "line 0" && g_shown[3] == "line 3");
+	FWWASM_CHECK(newest.stats().dropped == 6);
+}
+
+static void testCoalesce()
+{
+	g_shown.clear();
+	fwwasm::LogFeeder<8> feeder(0, 0, fwwasm::logDropOldest, showLine);
+	feeder.push("timeout");
+	feeder.push("timeout");
+	feeder.push("timeout");
+	feeder.push("ok");
+	feeder.push("timeout");
+	FWWASM_CHECK(feeder.pending() == 3 && feeder.stats().coalesced == 2);
+	feeder.pump();
+	FWWASM_CHECK(g_shown.size() == 3 && g_shown[0] == "timeout (x3)" && g_shown[1] == "ok" && g_shown[2] == "timeout");
+
+	// a line too long for LINE_LEN is cut, and repeats of it still coalesce
+	g_shown.clear();
+	fwwasm::LogFeeder<4, 8> shortLines(0, 0, fwwasm::logDropOldest, showLine);
+	shortLines.push("0123456789");
+	shortLines.push("0123456789");
+	shortLines.pump();
+	FWWASM_CHECK(g_shown.size() == 1 && g_shown[0] == "0123456 (x2)");
+	FWWASM_CHECK(shortLines.stats().truncated == 2);
+}
+
+static void testRateLimit()
+{
+	g_shown.clear();
+	fwwasm::LogFeeder<64> feeder(0, 4, fwwasm::logDropOldest, showLine);
+	for (int i = 0; i < 50; i++)
+		feeder.pushf("burst {}", i);
+	bool limited = true;
+	unsigned int frames = 0;
+	while (feeder.pending())
+	{
+		limited = limited && feeder.pump() <= 4;
+		frames++;
+	}
+	FWWASM_CHECK(limited && frames == 13 && g_shown.size() == 50);
+	FWWASM_CHECK(g_shown[0] == "burst 0" && g_shown[49] == "burst 49");
+	for (int i = 0; i < 10; i++)
+		feeder.pushf("late {}", i);
+	FWWASM_CHECK(feeder.flush() == 10 && feeder.pending() == 0);
+}
+
+static void testMirror()
+{
+	g_shown.clear();
+	g_mirror.clear();
+	fwwasm::BufferedFileWriter<64> file(1, mirrorWrite);
+	fwwasm::LogFeeder<2> feeder(0, 1, fwwasm::logDropOldest, showLine);
+	feeder.setMirror(&file);
+	feeder.push("a");
+	feeder.push("a");
+	feeder.push("b");
+	feeder.push("c");
+	file.flush();
+	// the mirror keeps the duplicate and the line the ring dropped
+	FWWASM_CHECK(g_mirror == "a\na\nb\nc\n");
+	FWWASM_CHECK(feeder.stats().dropped == 1);
+}
+
+int main()
+{
+	testOverflow();
+	testCoalesce();
+	testRateLimit();
+	testMirror();
+	return fwwasm_test::result("test_log");
+}
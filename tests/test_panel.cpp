@@ -0,0 +1,174 @@
+// PanelBatch against a stand-in sink that records what each control shows: whatever mix of integer, float and text
+// updates is queued, every control must end up showing the last value set, with unchanged values not resent. Also times
+// a dashboard refresh sent straight to the imports against the same refresh through a batch.
+
+#include "fwwasm_panel.h"
+#include "fwwasm_test.h"
+
+#include <string>
+
+static std::string g_shown[64];
+static unsigned int g_calls;
+
+static void showValue(int, int control, int value)
+{
+	g_shown[control] = "i" + std::to_string(value);
+	g_calls++;
+}
+
+static void showFloat(int, int control, float value)
+{
+	g_shown[control] = "f" + std::to_string(value);
+	g_calls++;
+}
+
+static void showText(int, int control, const char* text)
+{
+	g_shown[control] = std::string("t") + text;
+	g_calls++;
+}
+
+static void showProperty(int, int, controlProperty, int)
+{
+	g_calls++;
+}
+
+// 20 updates per frame over 16 controls, mostly values that did not change since the last frame
+static void benchmark(const fwwasm::PanelSink& sink)
+{
+	const unsigned int frames = 20000, perFrame = 20;
+	unsigned int seed = 7;
+	g_calls = 0;
+	double directNs = fwwasm_test::nsPerCall(frames, [&](unsigned int frame) {
+		for (unsigned int n = 0; n < perFrame; n++)
+		{
+			seed = seed * 1103515245u + 12345u;
+			int control = static_cast<int>(seed >> 16) % 16;
+			if (n % 4 == 0)
+				sink.setValueFloat(0, control, static_cast<float>(frame % 50) * 0.5f);
+			else
+				sink.setValue(0, control, static_cast<int>(seed >> 28));
+		}
+	});
+	unsigned int directCalls = g_calls;
+
+	fwwasm::PanelBatch<> panel(0, sink);
+	seed = 7;
+	g_calls = 0;
+	double batchedNs = fwwasm_test::nsPerCall(frames, [&](unsigned int frame) {
+		panel.begin();
+		for (unsigned int n = 0; n < perFrame; n++)
+		{
+			seed = seed * 1103515245u + 12345u;
+			int control = static_cast<int>(seed >> 16) % 16;
+			if (n % 4 == 0)
+				panel.setValueFloat(control, static_cast<float>(frame % 50) * 0.5f);
+			else
+				panel.setValue(control, static_cast<int>(seed >> 28));
+		}
+		panel.commit();
+	});
+	unsigned int batchedCalls = g_calls;
+	FWWASM_CHECK(batchedCalls < directCalls);
+	printf("per control: %.1f M updates/s, %.1f imports/frame; batched: %.1f M updates/s, %.1f imports/frame\n",
+		perFrame * 1000.0 / directNs, static_cast<double>(directCalls) / frames, perFrame * 1000.0 / batchedNs,
+		static_cast<double>(batchedCalls) / frames);
+}
+
+int main()
+{
+	fwwasm::PanelSink sink = { showValue, showFloat, showText, showProperty };
+
+	// an integer, then text, then the same integer again: the control shows the text, so the integer must be sent
+	fwwasm::PanelBatch<> panel(0, sink);
+	panel.begin();
+	panel.setValue(3, 5);
+	FWWASM_CHECK(panel.commit() == 1);
+	panel.begin();
+	panel.setValueText(3, "hello");
+	FWWASM_CHECK(panel.commit() == 1);
+	panel.begin();
+	panel.setValue(3, 5);
+	FWWASM_CHECK(panel.commit() == 1);
+	FWWASM_CHECK(g_shown[3] == "i5");
+	// and inside one transaction the last of the three kinds wins
+	panel.begin();
+	panel.setValueText(3, "x");
+	panel.setValueFloat(3, 2.5f);
+	panel.setValue(3, 7);
+	FWWASM_CHECK(panel.pending() == 1);
+	panel.commit();
+	FWWASM_CHECK(g_shown[3] == "i7");
+
+	// a changed text is sent and an unchanged one is not
+	panel.begin();
+	panel.setValueText(4, "abc");
+	panel.commit();
+	panel.begin();
+	panel.setValueText(4, "abd");
+	FWWASM_CHECK(panel.commit() == 1);
+	panel.begin();
+	panel.setValueText(4, "abd");
+	FWWASM_CHECK(panel.commit() == 0);
+
+	// rewriting the same texts many times in one transaction must not run the text buffer out
+	fwwasm::PanelBatch<16, 128> small(0, sink);
+	small.begin();
+	char text[32];
+	for (int round = 0; round < 200; round++)
+		for (int control = 10; control < 14; control++)
+		{
+			snprintf(text, sizeof(text), "control %d round %d", control, round);
+			small.setValueText(control, text);
+		}
+	FWWASM_CHECK(small.stats().overflows == 0);
+	FWWASM_CHECK(small.commit() == 4);
+	FWWASM_CHECK(g_shown[10] == "tcontrol 10 round 199" && g_shown[13] == "tcontrol 13 round 199");
+
+	// a dashboard refresh with random values against a model of what each control should show
+	fwwasm::PanelBatch<> dash(0, sink);
+	std::string expected[64];
+	for (int control = 0; control < 64; control++)
+		g_shown[control].clear();
+	unsigned int seed = 1;
+	for (int frame = 0; frame < 2000; frame++)
+	{
+		dash.begin();
+		for (int n = 0; n < 20; n++)
+		{
+			seed = seed * 1103515245u + 12345u;
+			int control = static_cast<int>(seed >> 16) % 40;
+			int value = static_cast<int>(seed >> 8) % 3;
+			switch ((seed >> 24) % 3)
+			{
+				case 0:
+					dash.setValue(control, value);
+					expected[control] = "i" + std::to_string(value);
+					break;
+				case 1:
+					dash.setValueFloat(control, static_cast<float>(value));
+					expected[control] = "f" + std::to_string(static_cast<float>(value));
+					break;
+				default:
+					snprintf(text, sizeof(text), "v%d", value);
+					dash.setValueText(control, text);
+					expected[control] = std::string("t") + text;
+					break;
+			}
+		}
+		dash.commit();
+		bool same = true;
+		for (int control = 0; control < 40; control++)
+			same = same && g_shown[control] == expected[control];
+		FWWASM_CHECK(same);
+		if (!same)
+			break;
+	}
+	fwwasm::PanelBatchStats stats = dash.stats();
+	FWWASM_CHECK(stats.overflows == 0);
+	printf("2000 refreshes: %u queued, %u coalesced, %u skipped, %u applied\n", stats.queued, stats.coalesced, stats.skipped,
+		stats.applied);
+
+	benchmark(sink);
+	return fwwasm_test::result("test_panel");
+}
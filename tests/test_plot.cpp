@@ -0,0 +1,79 @@
+// minMax() and PlotFeeder against a plain scalar reference. Built once for the host and, where a wasm toolchain is
+// available, again with -msimd128 so the SIMD128 reduction is checked against the same expectations.
+
+#include "fwwasm_plot.h"
+#include "fwwasm_test.h"
+
+#include <math.h>
+#include <vector>
+
+static std::vector<int> g_sent;
+
+static void plotData(int, int, int value)
+{
+	g_sent.push_back(value);
+}
+
+int main()
+{
+	// every length and start offset around the four lane blocks, including the unaligned tails
+	static int samples[256];
+	unsigned int seed = 7;
+	for (int i = 0; i < 256; i++)
+	{
+		seed = seed * 1103515245u + 12345u;
+		samples[i] = static_cast<int>(seed) >> 4;
+	}
+	bool same = true;
+	for (size_t start = 0; start < 8; start++)
+		for (size_t count = 1; count + start <= 256; count++)
+		{
+			int lo, hi;
+			fwwasm::minMax(samples + start, count, lo, hi);
+			int refLo = samples[start], refHi = samples[start];
+			for (size_t i = start; i < start + count; i++)
+			{
+				refLo = samples[i] < refLo ? samples[i] : refLo;
+				refHi = samples[i] > refHi ? samples[i] : refHi;
+			}
+			same = same && lo == refLo && hi == refHi;
+		}
+	FWWASM_CHECK(same);
+
+	// 2 s of 8 kHz audio on a 320 pixel plot: two values per pixel, and a one sample spike survives decimation
+	fwwasm::PlotFeeder feeder(0, 320, 2000, 8000, plotData);
+	std::vector<int> block(1000);
+	for (int n = 0; n < 16; n++)
+	{
+		for (int i = 0; i < 1000; i++)
+			block[i] = static_cast<int>(1000 * sin((n * 1000 + i) * 0.01));
+		if (n == 7)
+			block[500] = 5000;
+		feeder.push(block.data(), block.size());
+	}
+	feeder.flush();
+	fwwasm::PlotFeederStats stats = feeder.stats();
+	FWWASM_CHECK(stats.samples == 16000);
+	FWWASM_CHECK(stats.pixels == 320);
+	FWWASM_CHECK(stats.emitted <= 2 * stats.pixels);
+	int peak = g_sent[0];
+	for (size_t i = 1; i < g_sent.size(); i++)
+		peak = g_sent[i] > peak ? g_sent[i] : peak;
+	FWWASM_CHECK(peak == 5000);
+
+	// below two samples per pixel the samples are passed through unchanged
+	g_sent.clear();
+	fwwasm::PlotFeeder slow(0, 320, 2000, 100, plotData);
+	slow.push(block.data(), 10);
+	FWWASM_CHECK(g_sent.size() == 10 && g_sent[9] == block[9]);
+
+	int lo, hi;
+	volatile int sink;
+	double ns = fwwasm_test::nsPerCall(20000, [&](unsigned int i) {
+		fwwasm::minMax(samples + (i & 7), 200, lo, hi);
+		sink = lo ^ hi;
+	});
+	(void)sink;
+	printf("minMax over 200 samples: %.1f ns (%.2f ns per sample)\n", ns, ns / 200);
+	return fwwasm_test::result("test_plot");
+}
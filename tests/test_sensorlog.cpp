@@ -0,0 +1,120 @@
+// Sensor log round trip: lossless decode, indexed and unindexed seeks, a log cut off before finish(), a block lost by
+// writeFile(), and the encoded size of a slowly changing 4 channel trace.
+
+#include "fwwasm_sensorlog.h"
+#include "fwwasm_test.h"
+
+#include <math.h>
+#include <vector>
+
+static std::vector<unsigned char> g_file;
+static unsigned int g_writes;
+static unsigned int g_failWrite; // 1-based writeFile() call that reports an error, 0 for none
+
+static int writeToMemory(int, unsigned char* data, int bytes)
+{
+	if (++g_writes == g_failWrite)
+		return 0;
+	g_file.insert(g_file.end(), data, data + bytes);
+	return bytes;
+}
+
+static void sampleAt(unsigned int i, int* v)
+{
+	v[0] = static_cast<int>(1000 * sin(i * 0.01));
+	v[1] = static_cast<int>(30 * cos(i * 0.1));
+	v[2] = 1000 + static_cast<int>(i % 7) - 3;
+	v[3] = i == 5000 ? -2147483647 - 1 : 2512 + static_cast<int>(i / 10000);
+}
+
+static void checkDecode(bool finished, unsigned int samples)
+{
+	fwwasm::SensorLogReader reader(g_file.data(), g_file.size());
+	FWWASM_CHECK(reader.valid());
+	FWWASM_CHECK(reader.hasIndex() == finished);
+	fwwasm::SensorSample s;
+	unsigned int count = 0;
+	bool exact = true;
+	while (reader.next(s))
+	{
+		int v[4];
+		sampleAt(count, v);
+		exact = exact && s.timestampMs == count * 10 && memcmp(s.values, v, sizeof(v)) == 0;
+		count++;
+	}
+	FWWASM_CHECK(exact);
+	FWWASM_CHECK(finished ? count == samples : count > 0 && count <= samples);
+
+	FWWASM_CHECK(reader.seek(123455));
+	FWWASM_CHECK(reader.next(s) && s.timestampMs == 123460);
+	unsigned int seeks = finished ? 1000 : 20;
+	double seekNs = fwwasm_test::nsPerCall(seeks, [&](unsigned int i) { reader.seek((i * 7919u) % (count * 10)); });
+	printf("%s log: seek %.1f us\n", finished ? "finished" : "unfinished", seekNs / 1000);
+}
+
+// a failed writeFile() loses a block; the index must still point at keyframes that reached the file
+static void testLostBlock()
+{
+	g_file.clear();
+	g_writes = 0;
+	g_failWrite = 4;
+	const unsigned int samples = 20000;
+	fwwasm::SensorLogWriter<4, 64> writer(64, writeToMemory);
+	writer.begin(1);
+	bool accepted = true;
+	for (unsigned int i = 0; i < samples; i++)
+	{
+		int v[4];
+		sampleAt(i, v);
+		accepted = writer.add(i * 10, v) && accepted;
+	}
+	writer.finish();
+	g_failWrite = 0;
+	FWWASM_CHECK(!accepted);
+	FWWASM_CHECK(writer.stats().bytes + 512 >= g_file.size() && writer.stats().bytes <= g_file.size() + 512);
+
+	fwwasm::SensorLogReader reader(g_file.data(), g_file.size());
+	FWWASM_CHECK(reader.valid() && reader.hasIndex());
+	FWWASM_CHECK(reader.seek(samples * 5));
+	fwwasm::SensorSample s;
+	unsigned int count = samples / 2;
+	bool exact = true;
+	while (reader.next(s))
+	{
+		int v[4];
+		sampleAt(count, v);
+		exact = exact && s.timestampMs == count * 10 && memcmp(s.values, v, sizeof(v)) == 0;
+		count++;
+	}
+	FWWASM_CHECK(exact && count == samples);
+}
+
+int main()
+{
+	const unsigned int samples = 360000; // 1 h at 100 Hz
+	fwwasm::SensorLogWriter<4, 64> writer(64, writeToMemory);
+	writer.begin(1);
+	for (unsigned int i = 0; i < samples; i++)
+	{
+		int v[4];
+		sampleAt(i, v);
+		writer.add(i * 10, v);
+		if (i == samples / 2)
+			writer.flush();
+	}
+	std::vector<unsigned char> partial = g_file;
+	FWWASM_CHECK(writer.finish());
+	fwwasm::SensorLogStats stats = writer.stats();
+	FWWASM_CHECK(stats.samples == samples);
+	FWWASM_CHECK(stats.bytes == g_file.size());
+	printf("%u samples, %.2f bytes/sample, %u writeFile() calls\n", stats.samples, static_cast<double>(stats.bytes) / samples,
+		stats.writeCalls);
+	checkDecode(true, samples);
+
+	// power lost before finish(): no index, readers fall back to scanning
+	g_file = partial;
+	checkDecode(false, samples);
+
+	testLostBlock();
+	return fwwasm_test::result("test_sensorlog");
+}
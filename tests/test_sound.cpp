@@ -0,0 +1,204 @@
+// SoundQueue, synthesize() and PcmRing against stand-ins: queued items play back to back and every completion reaches
+// the app even while the EventQueue app lane is full; synthesized waves match the scalar wave shapes (test_sound_simd128
+// checks the SIMD128 path against the same reference), also above the sample rate; a ring filled and drained in uneven
+// blocks returns every sample in order; and playback paced by a simulated 16 kHz clock reports the producer's CPU time
+// per second of audio and the underruns a jittery frame loop causes.
+
+#include "fwwasm_sound.h"
+#include "fwwasm_test.h"
+
+#include <chrono>
+#include <math.h>
+#include <vector>
+
+static std::vector<unsigned int> g_starts;
+
+static void playFile(const char*)
+{
+	g_starts.push_back(fwwasm_test::now);
+}
+
+static void playNumber(int, int, float, int)
+{
+	g_starts.push_back(fwwasm_test::now);
+}
+
+static void playTone(float, float, float, audioWaveType)
+{
+	g_starts.push_back(fwwasm_test::now);
+}
+
+static void testQueue()
+{
+	typedef fwwasm::EventQueue<4, 4, 2, 2> Queue;
+	fwwasm::EventSource none = { hasEvent, getEventData };
+	Queue events(none);
+	fwwasm::SoundIO io = { playFile, playNumber, playTone };
+	fwwasm::SoundQueue<> sound(io);
+	sound.onDone(fwwasm::postSoundDone<Queue>, &events);
+	fwwasm_test::now = 0;
+	int queued = 0;
+	for (int i = 0; i < 12; i++)
+		queued += sound.enqueueTone(440.0f + 10.0f * static_cast<float>(i), 50) > 0;
+	queued += sound.enqueueNumber(42, 300) > 0;
+	queued += sound.enqueueFile("done.wav", 400) > 0;
+	// the app only looks at its events after the sequence, so the app lane is full long before then
+	while (sound.busy() && fwwasm_test::now < 5000)
+	{
+		fwwasm_test::now += 1;
+		sound.update(fwwasm_test::now);
+	}
+	int delivered = 0, lastId = 0;
+	bool ordered = true;
+	fwwasm::Event ev;
+	for (int round = 0; round < 20 && delivered < queued; round++)
+	{
+		while (events.next(ev))
+		{
+			fwwasm::SoundDone done;
+			if (!fwwasm::soundDoneFromEvent(ev, done))
+				continue;
+			ordered = ordered && done.id == lastId + 1;
+			lastId = done.id;
+			delivered++;
+		}
+		sound.update(fwwasm_test::now);
+	}
+	FWWASM_CHECK(delivered == queued && ordered);
+	FWWASM_CHECK(sound.stats().retries > 0 && !sound.busy());
+	// back to back: each item starts when the previous one's duration is over
+	bool gapless = g_starts.size() == 14;
+	for (size_t i = 1; gapless && i < 12; i++)
+		gapless = g_starts[i] - g_starts[i - 1] == 50;
+	FWWASM_CHECK(gapless);
+	printf("sound queue: %d/%d completions delivered in order, %u refused and retried\n", delivered, queued, sound.stats().retries);
+}
+
+static void testSynthesize()
+{
+	static const audioWaveType kWaves[] = { WAVETYPE_SINE, WAVETYPE_SQUARE, WAVETYPE_SAWTOOTH, WAVETYPE_TRIANGLE };
+	const char* const kNames[] = { "sine", "square", "sawtooth", "triangle" };
+	for (int w = 0; w < 4; w++)
+	{
+		fwwasm::Oscillator osc = fwwasm::Oscillator::make(441.0f, 16000.0f, 0.5f, kWaves[w]);
+		std::vector<short> pcm(4003);
+		for (size_t done = 0; done < pcm.size(); done += 1001)
+			fwwasm::synthesize(pcm.data() + done, pcm.size() - done < 1001 ? pcm.size() - done : 1001, osc);
+		size_t off = 0;
+		for (size_t i = 0; i < pcm.size(); i++)
+		{
+			double phase = fmod(static_cast<double>(i) * 441.0 / 16000.0, 1.0);
+			// square and sawtooth jump at the cycle edges, where float phase rounding may land on either side
+			double edge = phase < 0.5 ? phase : 1.0 - phase;
+			if ((kWaves[w] == WAVETYPE_SQUARE || kWaves[w] == WAVETYPE_SAWTOOTH) && (edge < 1e-3 || fabs(phase - 0.5) < 1e-3))
+				continue;
+			float expected = fwwasm::detail::waveSample(kWaves[w], static_cast<float>(phase)) * 0.5f * 32767.0f;
+			off += fabsf(static_cast<float>(pcm[i]) - expected) > 40.0f;
+		}
+		FWWASM_CHECK(off == 0);
+		if (off)
+			printf("%s: %zu samples off\n", kNames[w], off);
+	}
+	// a step of 2.25 cycles per sample must wrap to 0.25 every sample, in the SIMD128 blocks and the scalar tail
+	for (int w = 0; w < 4; w++)
+	{
+		fwwasm::Oscillator fast = fwwasm::Oscillator::make(36000.0f, 16000.0f, 0.5f, kWaves[w]);
+		short pcm[103];
+		fwwasm::synthesize(pcm, 103, fast);
+		bool same = fast.phase >= 0 && fast.phase < 1;
+		for (int i = 0; i < 103; i++)
+		{
+			float expected = fwwasm::detail::waveSample(kWaves[w], static_cast<float>(fmod(i * 2.25, 1.0))) * 0.5f * 32767.0f;
+			same = same && fabsf(static_cast<float>(pcm[i]) - expected) <= 40.0f;
+		}
+		FWWASM_CHECK(same);
+	}
+
+	fwwasm::Oscillator osc = fwwasm::Oscillator::make(440.0f, 16000.0f);
+	short block[256];
+	volatile short sink;
+	double ns = fwwasm_test::nsPerCall(20000, [&](unsigned int) {
+		fwwasm::synthesize(block, 256, osc);
+		sink = block[7];
+	});
+	(void)sink;
+	printf("synthesize sine: %.2f ns per sample\n", ns / 256);
+}
+
+static void testRing()
+{
+	fwwasm::PcmRing<1000> ring;
+	short in[300], out[300];
+	short next = 0, expect = 0;
+	bool ordered = true;
+	unsigned int seed = 3;
+	for (int round = 0; round < 20000; round++)
+	{
+		seed = seed * 1103515245u + 12345u;
+		size_t writeCount = (seed >> 16) % 300;
+		size_t readCount = (seed >> 8) % 300;
+		size_t room = ring.space();
+		for (size_t i = 0; i < writeCount; i++)
+			in[i] = static_cast<short>(next + i);
+		size_t stored = ring.write(in, writeCount);
+		FWWASM_CHECK(stored == (writeCount < room ? writeCount : room));
+		next = static_cast<short>(next + stored);
+		size_t got = ring.read(out, readCount);
+		for (size_t i = 0; i < got; i++)
+			ordered = ordered && out[i] == static_cast<short>(expect + i);
+		for (size_t i = got; i < readCount; i++)
+			ordered = ordered && out[i] == 0;
+		expect = static_cast<short>(expect + got);
+		FWWASM_CHECK(ring.available() + ring.space() == 1000);
+	}
+	FWWASM_CHECK(ordered);
+	fwwasm::PcmRingStats stats = ring.stats();
+	FWWASM_CHECK(stats.written == stats.read - stats.silence + ring.available());
+	FWWASM_CHECK(stats.underruns > 0 && stats.overruns > 0);
+	printf("pcm ring: %u samples through a 1000 sample ring, %u underruns, %u overruns\n", stats.written, stats.underruns,
+		stats.overruns);
+}
+
+// 60 s of 16 kHz audio: a simulated clock has the consumer take 16 samples every millisecond, while the app loop
+// refills the ring in 256 sample blocks once per frame, every 10 to 30 ms with a 120 ms stall now and then
+template <size_t SAMPLES>
+static unsigned int pacedPlayback()
+{
+	fwwasm::PcmRing<SAMPLES> ring;
+	fwwasm::Oscillator osc = fwwasm::Oscillator::make(440.0f, 16000.0f);
+	short block[256], out[16];
+	unsigned int seed = 11, nextFrame = 0;
+	double producerNs = 0;
+	const unsigned int seconds = 60;
+	for (unsigned int ms = 0; ms < seconds * 1000; ms++)
+	{
+		if (ms == nextFrame)
+		{
+			std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+			while (ring.space() >= 256)
+			{
+				fwwasm::synthesize(block, 256, osc);
+				ring.write(block, 256);
+			}
+			producerNs += std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+			seed = seed * 1103515245u + 12345u;
+			nextFrame = ms + ((seed >> 16) % 100 == 0 ? 120 : 10 + (seed >> 8) % 21);
+		}
+		ring.read(out, 16);
+	}
+	fwwasm::PcmRingStats stats = ring.stats();
+	printf("paced %4zu sample ring: producer %.3f ms CPU per second of audio, %u underruns, %u samples of silence\n", SAMPLES,
+		producerNs / 1e6 / seconds, stats.underruns, stats.silence);
+	return stats.underruns;
+}
+
+int main()
+{
+	testQueue();
+	testSynthesize();
+	testRing();
+	// the stalls outlast a 1024 sample ring (64 ms) but not a 4096 sample one (256 ms)
+	FWWASM_CHECK(pacedPlayback<1024>() > 0);
+	FWWASM_CHECK(pacedPlayback<4096>() == 0);
+	return fwwasm_test::result("test_sound");
+}
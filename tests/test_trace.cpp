@@ -0,0 +1,154 @@
+// ImportTrace record and replay against stand-in imports: a UART that delivers fewer bytes than asked for is recorded
+// with only the bytes that arrived and replays them exactly, a replay that runs on past the recording reports those
+// calls apart from divergences, and a call the trace does not expect is one divergence that leaves the records after it
+// in step.
+
+#include "fwwasm_trace.h"
+#include "fwwasm_test.h"
+
+#include <vector>
+
+static std::vector<unsigned char> g_file;
+static unsigned int g_uartCalls;
+
+static int fileWrite(int, unsigned char* data, int bytes)
+{
+	g_file.insert(g_file.end(), data, data + bytes);
+	return bytes;
+}
+
+static unsigned int deviceMillis()
+{
+	return fwwasm_test::now;
+}
+
+static int deviceRand()
+{
+	return static_cast<int>(fwwasm_test::now * 2654435761u);
+}
+
+static int none()
+{
+	return 0;
+}
+
+static int noEvent(unsigned char*)
+{
+	return -1;
+}
+
+static int uartCount()
+{
+	return static_cast<int>(g_uartCalls % 5);
+}
+
+// asked for up to 64 bytes, delivers a handful
+static int uartRead(unsigned char* data, int length)
+{
+	int got = static_cast<int>(g_uartCalls++ % 5);
+	for (int i = 0; i < length; i++)
+		data[i] = i < got ? static_cast<unsigned char>('a' + (g_uartCalls + i) % 26) : 0xEE;
+	return got;
+}
+
+static int radioCount(int)
+{
+	return 0;
+}
+
+static int radioRead(int, unsigned char*, int)
+{
+	return 0;
+}
+
+int main()
+{
+	fwwasm::TraceImports io = { deviceMillis, deviceRand, none, noEvent, uartCount, uartRead, radioCount, radioRead };
+	std::vector<std::vector<unsigned char> > reads;
+	std::vector<int> results;
+	{
+		fwwasm::ImportTrace<> trace(io, fileWrite);
+		trace.record(1);
+		for (int i = 0; i < 200; i++)
+		{
+			fwwasm_test::now += 3;
+			trace.millis();
+			unsigned char data[64];
+			int got = trace.UARTDataRead(data, sizeof(data));
+			results.push_back(got);
+			reads.push_back(std::vector<unsigned char>(data, data + (got > 0 ? got : 0)));
+		}
+		trace.flush();
+	}
+	// 200 millis records, 200 read records with their 0-4 bytes: nowhere near 200 x 64 bytes of buffer
+	FWWASM_CHECK(g_file.size() < 2000);
+	printf("200 UART reads of up to 64 bytes: %zu trace bytes\n", g_file.size());
+
+	fwwasm::TraceImports silent = { nullptr, nullptr, nullptr, nullptr, nullptr, nullptr, nullptr, nullptr };
+	{
+		fwwasm::ImportTrace<> trace(silent, fileWrite);
+		FWWASM_CHECK(trace.replay(g_file.data(), g_file.size()));
+		bool same = true;
+		for (size_t i = 0; i < reads.size(); i++)
+		{
+			unsigned int t = trace.millis();
+			same = same && t == 3 * (i + 1);
+			unsigned char data[64];
+			memset(data, 0, sizeof(data));
+			int got = trace.UARTDataRead(data, sizeof(data));
+			same = same && got == results[i] && memcmp(data, reads[i].data(), reads[i].size()) == 0;
+		}
+		FWWASM_CHECK(same);
+		// the app keeps running after the recording ends
+		for (int i = 0; i < 10; i++)
+		{
+			trace.millis();
+			trace.wilirand();
+		}
+		fwwasm::TraceStats stats = trace.stats();
+		FWWASM_CHECK(stats.divergences == 0 && stats.pastEnd == 20);
+		FWWASM_CHECK(!trace.replaying());
+	}
+	{
+		// an app that asks for something else than was recorded diverges once per mismatched call
+		fwwasm::ImportTrace<> trace(silent, fileWrite);
+		trace.replay(g_file.data(), g_file.size());
+		trace.wilirand();
+		FWWASM_CHECK(trace.stats().divergences == 1 && trace.stats().pastEnd == 0);
+		FWWASM_CHECK(trace.millis() == 3);
+	}
+	{
+		// one extra call halfway through: every later answer still comes from the record it was recorded for
+		fwwasm::ImportTrace<> trace(silent, fileWrite);
+		trace.replay(g_file.data(), g_file.size());
+		bool same = true;
+		for (size_t i = 0; i < reads.size(); i++)
+		{
+			if (i == 100)
+				trace.hasEvent();
+			same = same && trace.millis() == 3 * (i + 1);
+			unsigned char data[64];
+			int got = trace.UARTDataRead(data, sizeof(data));
+			same = same && got == results[i] && memcmp(data, reads[i].data(), reads[i].size()) == 0;
+		}
+		FWWASM_CHECK(same);
+		FWWASM_CHECK(trace.stats().divergences == 1 && !trace.replaying());
+	}
+	{
+		// a record claiming more bytes than the caller's buffer is a divergence, not an overrun
+		static const unsigned char kLong[] = { 'F', 'W', 'T', 'R', 2, 0, 0, 0, fwwasm::traceUARTRead, 4, 8, 'a', 'b', 'c', 'd' };
+		fwwasm::ImportTrace<> trace(silent, fileWrite);
+		trace.replay(kLong, sizeof(kLong));
+		unsigned char data[4] = { 0, 0, 0x55, 0x55 };
+		FWWASM_CHECK(trace.UARTDataRead(data, 2) <= 0);
+		FWWASM_CHECK(data[2] == 0x55 && data[3] == 0x55 && trace.stats().divergences == 1);
+	}
+	{
+		// the reader still reads version 1 traces, whose UART records hold the full requested length
+		static const unsigned char kV1[] = { 'F', 'W', 'T', 'R', 1, 0, 0, 0, fwwasm::traceUARTRead, 8, 2, 'h', 'i', 0, 0 };
+		fwwasm::TraceReader reader(kV1, sizeof(kV1));
+		fwwasm::TraceRecord r;
+		FWWASM_CHECK(reader.valid() && reader.next(r) && r.value == 1 && r.dataLength == 4 && reader.atEnd());
+	}
+	return fwwasm_test::result("test_trace");
+}
@@ -0,0 +1,111 @@
+// ZoomIOScripts against a stand-in runZoomIOScript() that records the script it was given: placeholders render in
+// decimal and hex, negatives and "$$" come out right, bad templates are refused, and a run with unchanged parameters
+// reuses the last rendered text.
+
+#include "fwwasm_zoomio.h"
+#include "fwwasm_test.h"
+
+#include <string>
+
+static std::string g_script;
+static unsigned int g_runs;
+
+static int recordScript(const char* szScript)
+{
+	g_script = szScript;
+	g_runs++;
+	return 1;
+}
+
+static void testRender()
+{
+	fwwasm::ZoomIOScripts<4> zoom(recordScript);
+	int pulse = zoom.compile(FWWASM_ZOOMIO("pin $0 high $1 ms mask $x2 cost $$5"));
+	FWWASM_CHECK(pulse == 0 && zoom.parameterCount(pulse) == 3);
+	int params[] = { 12, -250, 0xBEEF };
+	FWWASM_CHECK(zoom.run(pulse, params, 3) == 1);
+	FWWASM_CHECK(g_script == "pin 12 high -250 ms mask BEEF cost $5");
+
+	// hex prints the two's complement bit pattern, decimal handles INT_MIN, missing parameters are 0
+	params[0] = -2147483647 - 1;
+	params[2] = -1;
+	zoom.run(pulse, params, 3);
+	FWWASM_CHECK(g_script == "pin -2147483648 high -250 ms mask FFFFFFFF cost $5");
+	zoom.run(pulse, params, 1);
+	FWWASM_CHECK(g_script == "pin -2147483648 high 0 ms mask 0 cost $5");
+
+	// a parameter used twice and a template that is only a parameter
+	int twice = zoom.compile("$3,$x3,$3");
+	int bare = zoom.compile("$0");
+	FWWASM_CHECK(zoom.parameterCount(twice) == 4 && zoom.parameterCount(bare) == 1);
+	int wide[] = { 0, 0, 0, 255 };
+	zoom.run(twice, wide, 4);
+	FWWASM_CHECK(g_script == "255,FF,255");
+	zoom.run(bare, wide, 4);
+	FWWASM_CHECK(g_script == "0" && std::string(zoom.rendered(twice)) == "255,FF,255");
+}
+
+static void testValidate()
+{
+	FWWASM_CHECK(fwwasm::zoomIOValidate("") == fwwasm::zoomIOOk);
+	FWWASM_CHECK(fwwasm::zoomIOValidate("a $8") == fwwasm::zoomIOBadParameter);
+	FWWASM_CHECK(fwwasm::zoomIOValidate("a $x") == fwwasm::zoomIOBadParameter);
+	FWWASM_CHECK(fwwasm::zoomIOValidate("a $") == fwwasm::zoomIOBadParameter);
+	FWWASM_CHECK(fwwasm::zoomIOValidate("a\x01") == fwwasm::zoomIOBadCharacter);
+	FWWASM_CHECK(fwwasm::zoomIOValidate("a\tb\r\n") == fwwasm::zoomIOOk);
+	std::string longText(FWWASM_ZOOMIO_SCRIPT_MAX, 'a');
+	FWWASM_CHECK(fwwasm::zoomIOValidate(longText.c_str()) == fwwasm::zoomIOTooLong);
+	std::string segments;
+	for (size_t i = 0; i <= fwwasm::ZOOMIO_SEGMENTS_MAX / 2; i++)
+		segments += "a$0";
+	FWWASM_CHECK(fwwasm::zoomIOValidate(segments.c_str()) == fwwasm::zoomIOTooManySegments);
+
+	fwwasm::ZoomIOScripts<1> zoom(recordScript);
+	FWWASM_CHECK(zoom.compile("$9") == zoom.kInvalid && zoom.lastError() == fwwasm::zoomIOBadParameter);
+	FWWASM_CHECK(zoom.compile("ok") == 0);
+	FWWASM_CHECK(zoom.compile("full") == zoom.kInvalid);
+	FWWASM_CHECK(zoom.run(1) == -1 && zoom.run(-1) == -1);
+	FWWASM_CHECK(zoom.stats().rejected == 2 && zoom.stats().errors == 2);
+
+	// a template that fits can still render past the limit once parameters are substituted
+	std::string edge(FWWASM_ZOOMIO_SCRIPT_MAX - 3, 'a');
+	edge += "$0";
+	fwwasm::ZoomIOScripts<1> tight(recordScript);
+	int handle = tight.compile(edge.c_str());
+	int small[] = { 7 };
+	int large[] = { 123456 };
+	FWWASM_CHECK(tight.run(handle, small, 1) == 1);
+	FWWASM_CHECK(tight.run(handle, large, 1) == -1 && tight.stats().errors == 1);
+}
+
+static void testCache()
+{
+	fwwasm::ZoomIOScripts<2> zoom(recordScript);
+	int handle = zoom.compile("set $0 to $x1");
+	int a[] = { 1, 16 };
+	int b[] = { 2, 16 };
+	g_runs = 0;
+	for (int i = 0; i < 100; i++)
+		zoom.run(handle, (i / 10) % 2 ? b : a, 2);
+	// ten changes of parameters, every run still reaches the runner
+	FWWASM_CHECK(zoom.stats().renders == 10 && zoom.stats().runs == 100 && g_runs == 100);
+	FWWASM_CHECK(g_script == "set 2 to 10");
+	// parameters the template does not use do not force a render
+	int extra[] = { 2, 16, 99 };
+	zoom.run(handle, extra, 3);
+	FWWASM_CHECK(zoom.stats().renders == 10);
+
+	volatile int sink;
+	double cachedNs = fwwasm_test::nsPerCall(200000, [&](unsigned int) { sink = zoom.run(handle, a, 2); });
+	double renderNs = fwwasm_test::nsPerCall(200000, [&](unsigned int i) { sink = zoom.run(handle, i & 1 ? a : b, 2); });
+	(void)sink;
+	printf("run: %.1f ns cached, %.1f ns rendered\n", cachedNs, renderNs);
+}
+
+int main()
+{
+	testRender();
+	testValidate();
+	testCache();
+	return fwwasm_test::result("test_zoomio");
+}
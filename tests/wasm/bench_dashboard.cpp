@@ -0,0 +1,30 @@
+// Benchmark app for fwwasmbench: a dashboard that drains its events, refreshes 24 controls through a panel batch and
+// logs a formatted status line every few frames.
+
+#include "fwwasm_events.h"
+#include "fwwasm_log.h"
+#include "fwwasm_panel.h"
+
+static fwwasm::EventQueue<> events;
+static fwwasm::PanelBatch<> panel(0);
+static fwwasm::LogFeeder<16> status(0, 2);
+static unsigned int frame;
+
+WASM_EXPORT void benchFrame()
+{
+	fwwasm::Event ev;
+	while (events.next(ev))
+		status.pushf("event {}", ev.type);
+
+	unsigned int now = millis();
+	panel.begin();
+	for (int control = 0; control < 16; control++)
+		panel.setValue(control, static_cast<int>((now / 100 + static_cast<unsigned int>(control)) % 8));
+	for (int control = 16; control < 24; control++)
+		panel.setValueFloat(control, static_cast<float>(now % 1000) * 0.01f);
+	panel.commit();
+
+	if (++frame % 8 == 0)
+		status.pushf("t {} ms, {} panel updates", now, panel.stats().applied);
+	status.pump();
+}
@@ -0,0 +1,35 @@
+// Benchmark app for fwwasmbench: accelerometer samples arriving at 100 Hz run through the fusion pipeline in batches
+// of 32, go to a sensor log file and are decimated onto a plot.
+
+#include "fwwasm_accel.h"
+#include "fwwasm_plot.h"
+#include "fwwasm_sensorlog.h"
+
+static fwwasm::AccelBatch<32> batch;
+static fwwasm::AccelFusion<32> fusion(2.0f, 10);
+static fwwasm::SensorLogWriter<3> sensorLog;
+static fwwasm::PlotFeeder plot(0, 240, 5000, 100);
+static unsigned int nextSample;
+
+WASM_EXPORT void benchSetup()
+{
+	// the runner's OpenFile stand-in ignores the mode
+	sensorLog.begin(openFile("accel.fwsl", 0));
+}
+
+WASM_EXPORT void benchFrame()
+{
+	unsigned int now = millis();
+	for (; nextSample <= now; nextSample += 10)
+	{
+		int n = static_cast<int>(nextSample / 10);
+		int raw[3] = { (n * 37) % 200 - 100, (n * 11) % 60 - 30, 1000 + (n * 53) % 80 };
+		sensorLog.add(nextSample, raw);
+		plot.push(raw[2]);
+		if (batch.push(static_cast<float>(raw[0]) * 0.001f, static_cast<float>(raw[1]) * 0.001f, static_cast<float>(raw[2]) * 0.001f))
+		{
+			fusion.process(batch);
+			batch.clear();
+		}
+	}
+}
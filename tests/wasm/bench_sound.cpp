@@ -0,0 +1,28 @@
+// Benchmark app for fwwasmbench: a tone sequence on the sound queue while a synthesized 16 kHz stream is kept ahead of
+// a consumer that takes 16 samples per millisecond.
+
+#include "fwwasm_sound.h"
+
+static fwwasm::SoundQueue<> sound;
+static fwwasm::PcmRing<2048> ring;
+static fwwasm::Oscillator osc = fwwasm::Oscillator::make(440.0f, 16000.0f);
+static unsigned int lastMs;
+
+WASM_EXPORT void benchFrame()
+{
+	unsigned int now = millis();
+	if (!sound.busy())
+		for (int i = 0; i < 4; i++)
+			sound.enqueueTone(440.0f + 110.0f * static_cast<float>(i), 100);
+	sound.update(now);
+
+	short block[256];
+	for (unsigned int ms = lastMs; ms < now; ms++)
+		ring.read(block, 16);
+	lastMs = now;
+	while (ring.space() >= 256)
+	{
+		fwwasm::synthesize(block, 256, osc);
+		ring.write(block, 256);
+	}
+}
@@ -0,0 +1,68 @@
+// Host-side converter for fwwasm_sensorlog.h binary logs.
+//
+// usage: fwsensorlog <log file> [seek ms] [max samples]
+// Writes the samples as CSV to stdout and a size summary to stderr.
+
+#include "fwwasm_sensorlog.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <vector>
+
+int main(int argc, char** argv)
+{
+	if (argc < 2)
+	{
+		fprintf(stderr, "usage: %s <log file> [seek ms] [max samples]\n", argv[0]);
+		return 2;
+	}
+	FILE* f = fopen(argv[1], "rb");
+	if (!f)
+	{
+		fprintf(stderr, "cannot open %s\n", argv[1]);
+		return 1;
+	}
+	std::vector<unsigned char> data;
+	unsigned char block[4096];
+	size_t n;
+	while ((n = fread(block, 1, sizeof(block), f)) > 0)
+		data.insert(data.end(), block, block + n);
+	fclose(f);
+
+	fwwasm::SensorLogReader reader(data.data(), data.size());
+	if (!reader.valid())
+	{
+		fprintf(stderr, "%s is not a sensor log\n", argv[1]);
+		return 1;
+	}
+	if (argc > 2)
+	{
+		clock_t start = clock();
+		bool found = reader.seek(static_cast<unsigned int>(strtoul(argv[2], nullptr, 0)));
+		double us = 1e6 * static_cast<double>(clock() - start) / CLOCKS_PER_SEC;
+		fprintf(stderr, "seek %s in %.1f us (%s)\n", found ? "ok" : "past end", us, reader.hasIndex() ? "indexed" : "scanned");
+		if (!found)
+			return 0;
+	}
+	unsigned long limit = argc > 3 ? strtoul(argv[3], nullptr, 0) : 0;
+
+	printf("timestamp_ms");
+	for (size_t c = 0; c < reader.channels(); c++)
+		printf(",ch%u", static_cast<unsigned int>(c));
+	printf("\n");
+	fwwasm::SensorSample sample;
+	unsigned long count = 0;
+	while ((limit == 0 || count < limit) && reader.next(sample))
+	{
+		printf("%u", sample.timestampMs);
+		for (size_t c = 0; c < reader.channels(); c++)
+			printf(",%d", sample.values[c]);
+		printf("\n");
+		count++;
+	}
+	if (argc <= 2 && count)
+		fprintf(stderr, "%lu samples, %zu bytes, %.2f bytes/sample%s\n", count, data.size(),
+			static_cast<double>(data.size()) / static_cast<double>(count), reader.hasIndex() ? "" : ", no index (log was not finished)");
+	return 0;
+}
@@ -0,0 +1,78 @@
+// Host-side summary of fwwasm_trace.h import traces.
+//
+// usage: fwtrace <trace file> [-v]
+// Prints the number of calls and trace bytes per import, the recorded time span and the events seen per type;
+// -v also lists every record. Replay itself happens in a host build of the app through ImportTrace::replay().
+
+#include "fwwasm_trace.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <vector>
+
+int main(int argc, char** argv)
+{
+	if (argc < 2)
+	{
+		fprintf(stderr, "usage: %s <trace file> [-v]\n", argv[0]);
+		return 2;
+	}
+	bool verbose = argc > 2 && strcmp(argv[2], "-v") == 0;
+	FILE* f = fopen(argv[1], "rb");
+	if (!f)
+	{
+		fprintf(stderr, "cannot open %s\n", argv[1]);
+		return 1;
+	}
+	std::vector<unsigned char> data;
+	unsigned char block[4096];
+	size_t n;
+	while ((n = fread(block, 1, sizeof(block), f)) > 0)
+		data.insert(data.end(), block, block + n);
+	fclose(f);
+
+	fwwasm::TraceReader reader(data.data(), data.size());
+	if (!reader.valid())
+	{
+		fprintf(stderr, "%s is not an import trace\n", argv[1]);
+		return 1;
+	}
+	static const char* const kNames[] = { "", "millis", "wilirand", "hasEvent", "getEventData", "UARTDataRxCount", "UARTDataRead",
+		"RadioGetRxCount", "RadioRead" };
+	unsigned long calls[fwwasm::traceImportCount] = {};
+	unsigned long bytes[fwwasm::traceImportCount] = {};
+	unsigned long events[256] = {};
+	unsigned int first = 0, last = 0;
+	bool timed = false;
+	fwwasm::TraceRecord r;
+	size_t offset = reader.offset();
+	while (reader.next(r))
+	{
+		calls[r.import]++;
+		bytes[r.import] += reader.offset() - offset;
+		offset = reader.offset();
+		if (r.import == fwwasm::traceMillis)
+		{
+			if (!timed)
+				first = r.millis;
+			last = r.millis;
+			timed = true;
+		}
+		if (r.import == fwwasm::traceGetEventData && r.value >= 0 && r.value < 256)
+			events[r.value]++;
+		if (verbose)
+			printf("%8u %-16s value %d index %d length %d data %zu\n", r.millis, kNames[r.import], r.value, r.index, r.length,
+				r.dataLength);
+	}
+	if (!reader.atEnd())
+		fprintf(stderr, "damaged record at offset %zu\n", reader.offset());
+
+	printf("%zu bytes, %u ms recorded\n", data.size(), last - first);
+	for (int i = 1; i < fwwasm::traceImportCount; i++)
+		if (calls[i])
+			printf("%-16s %8lu calls %9lu bytes\n", kNames[i], calls[i], bytes[i]);
+	for (int t = 0; t < 256; t++)
+		if (events[t])
+			printf("event type %3d %8lu\n", t, events[t]);
+	return reader.atEnd() ? 0 : 1;
+}
@@ -0,0 +1,169 @@
+// Host-side benchmark runner for Free-Wili apps built to wasm32.
+//
+// usage: node fwwasmbench.mjs <app.wasm> [--frames N] [--frame-ms MS] [--max-us US] [--max-imports N] [--max-memory-kb KB]
+// Runs the module under Node.js' WebAssembly engine with every "wiliwasm" import bound to a stand-in, calls the app's
+// exported benchFrame() once per frame (after benchSetup() and a reactor's _initialize(), when exported) and prints
+// the time per frame, the import calls per frame and the linear memory high-water mark. Exits with 1 when a --max
+// limit is exceeded and 2 when the module cannot run.
+// Time is wall clock on the host after a warm-up, so compare it run to run on one machine; the import count and the
+// memory figures do not depend on the machine. The engine does not count instructions.
+
+import { readFileSync } from 'node:fs';
+import { performance } from 'node:perf_hooks';
+
+function usage(message)
+{
+	if (message)
+		console.error(message);
+	console.error('usage: node fwwasmbench.mjs <app.wasm> [--frames N] [--frame-ms MS] [--max-us US] [--max-imports N] ' +
+		'[--max-memory-kb KB]');
+	process.exit(2);
+}
+
+const options = { frames: 1000, frameMs: 16, maxUs: 0, maxImports: 0, maxMemoryKb: 0 };
+const flags = { '--frames': 'frames', '--frame-ms': 'frameMs', '--max-us': 'maxUs', '--max-imports': 'maxImports',
+	'--max-memory-kb': 'maxMemoryKb' };
+let path = null;
+for (let i = 2; i < process.argv.length; i++)
+{
+	const arg = process.argv[i];
+	if (flags[arg] && i + 1 < process.argv.length)
+	{
+		const value = Number(process.argv[++i]);
+		if (!(value >= 0))
+			usage(`bad value for ${arg}`);
+		options[flags[arg]] = value;
+	}
+	else if (!path && !arg.startsWith('--'))
+		path = arg;
+	else
+		usage(`unexpected argument ${arg}`);
+}
+if (!path || options.frames < 1)
+	usage();
+
+let memory = null;
+let now = 0;
+let seed = 1;
+const calls = new Map();
+
+// stand-ins with a result the helpers act on; every other import does nothing and returns 0
+const standIns = {
+	millis: () => now,
+	wilirand: () =>
+	{
+		seed = (Math.imul(seed, 1103515245) + 12345) >>> 0;
+		return seed >>> 16;
+	},
+	OpenFile: () => 1,
+	closeFile: () => 1,
+	writeFile: (handle, data, bytes) => bytes,
+	readFile: (handle, data, pBytes) =>
+	{
+		new DataView(memory.buffer).setInt32(pBytes, 0, true);
+		return 1;
+	},
+	setFilePosition: () => 1,
+	preAllocateSpaceForFile: () => 1,
+};
+
+const bytes = readFileSync(path);
+let module;
+try
+{
+	module = new WebAssembly.Module(bytes);
+}
+catch (e)
+{
+	console.error(`${path}: ${e.message}`);
+	process.exit(2);
+}
+
+// bind every import the module declares so no stand-in list has to be kept in step with fwwasm.h
+const imports = {};
+for (const imp of WebAssembly.Module.imports(module))
+{
+	if (imp.kind !== 'function')
+	{
+		console.error(`${path}: imports ${imp.kind} ${imp.module}.${imp.name}, only functions are supported`);
+		process.exit(2);
+	}
+	imports[imp.module] ??= {};
+	const key = `${imp.module}.${imp.name}`;
+	const fn = imp.module === 'wiliwasm' && standIns[imp.name] ? standIns[imp.name] : () => 0;
+	calls.set(key, 0);
+	imports[imp.module][imp.name] = (...args) =>
+	{
+		calls.set(key, calls.get(key) + 1);
+		return fn(...args);
+	};
+}
+
+const exports = new WebAssembly.Instance(module, imports).exports;
+memory = exports.memory;
+if (!(memory instanceof WebAssembly.Memory) || typeof exports.benchFrame !== 'function')
+{
+	console.error(`${path}: the module must export its memory and benchFrame()`);
+	process.exit(2);
+}
+exports._initialize?.();
+exports.benchSetup?.();
+
+function totalCalls()
+{
+	let total = 0;
+	for (const n of calls.values())
+		total += n;
+	return total;
+}
+
+// let the engine tier up before timing; these frames are not counted
+const warmup = Math.min(100, options.frames);
+for (let i = 0; i < warmup; i++)
+{
+	now += options.frameMs;
+	exports.benchFrame();
+}
+
+const before = new Map(calls);
+let elapsedMs = 0, maxFrameMs = 0, importCalls = 0, maxImports = 0, memoryBytes = memory.buffer.byteLength;
+for (let i = 0; i < options.frames; i++)
+{
+	now += options.frameMs;
+	const callsBefore = totalCalls();
+	const start = performance.now();
+	exports.benchFrame();
+	const ms = performance.now() - start;
+	const frameCalls = totalCalls() - callsBefore;
+	elapsedMs += ms;
+	maxFrameMs = Math.max(maxFrameMs, ms);
+	importCalls += frameCalls;
+	maxImports = Math.max(maxImports, frameCalls);
+	memoryBytes = Math.max(memoryBytes, memory.buffer.byteLength);
+}
+
+const usPerFrame = elapsedMs * 1000 / options.frames;
+const importsPerFrame = importCalls / options.frames;
+const memoryKb = memoryBytes / 1024;
+const heapBase = exports.__heap_base instanceof WebAssembly.Global ? exports.__heap_base.value : 0;
+const name = path.replace(/^.*[\\/]/, '');
+console.log(`${name}: ${options.frames} frames, ${usPerFrame.toFixed(2)} us/frame (max ${(maxFrameMs * 1000).toFixed(1)} us), ` +
+	`${importsPerFrame.toFixed(1)} imports/frame (max ${maxImports}), memory ${memoryKb.toFixed(0)} KB` +
+	(heapBase ? `, static data and stack ${(heapBase / 1024).toFixed(1)} KB` : ''));
+const busiest = [...calls].map(([key, n]) => [key, n - before.get(key)]).filter(([, n]) => n > 0).sort((a, b) => b[1] - a[1]);
+for (const [key, n] of busiest.slice(0, 8))
+	console.log(`  ${key}: ${(n / options.frames).toFixed(2)}/frame`);
+
+let failed = false;
+function limit(label, value, max, unit)
+{
+	if (max && value > max)
+	{
+		console.error(`${name}: ${label} ${value.toFixed(2)} ${unit} over the limit of ${max}`);
+		failed = true;
+	}
+}
+limit('time', usPerFrame, options.maxUs, 'us/frame');
+limit('import calls', importsPerFrame, options.maxImports, 'per frame');
+limit('memory', memoryKb, options.maxMemoryKb, 'KB');
+process.exit(failed ? 1 : 0);
@@ -0,0 +1,83 @@
+// Host-side checker for fwwasm_zoomio.h script templates.
+//
+// usage: fwzoomio <template file> [param...]
+// Validates the template, prints the script rendered with the given parameters and the cost of a run that has to
+// substitute parameters against one served from the cache. Exits with 1 if the template is invalid.
+// Only the template layer is checked: placeholders, characters, segment count and the rendered length. The rendered script
+// is not parsed as ZoomIO, so syntax errors in the script itself show up only when the firmware runs it.
+
+#include "fwwasm_zoomio.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <string>
+
+// stands in for runZoomIOScript(): succeeds with the rendered length, at least 1, whatever the first byte is
+static int countScript(const char* szScript)
+{
+	int length = static_cast<int>(strlen(szScript));
+	return length ? length : 1;
+}
+
+static double timeRuns(fwwasm::ZoomIOScripts<1>& scripts, int handle, int* params, size_t count, bool vary)
+{
+	const int kRuns = 200000;
+	clock_t start = clock();
+	for (int i = 0; i < kRuns; i++)
+	{
+		if (vary && count)
+			params[0] ^= 1;
+		scripts.run(handle, params, count);
+	}
+	return 1e9 * static_cast<double>(clock() - start) / CLOCKS_PER_SEC / kRuns;
+}
+
+int main(int argc, char** argv)
+{
+	if (argc < 2)
+	{
+		fprintf(stderr, "usage: %s <template file> [param...]\n", argv[0]);
+		fprintf(stderr, "checks template placeholders, characters and length only, not ZoomIO script syntax\n");
+		return 2;
+	}
+	FILE* f = fopen(argv[1], "rb");
+	if (!f)
+	{
+		fprintf(stderr, "cannot open %s\n", argv[1]);
+		return 1;
+	}
+	std::string text;
+	char block[4096];
+	size_t n;
+	while ((n = fread(block, 1, sizeof(block), f)) > 0)
+		text.append(block, n);
+	fclose(f);
+
+	static const char* const kErrors[] = { "ok", "bad parameter", "bad character", "too long", "too many segments" };
+	fwwasm::ZoomIOTemplateError error = fwwasm::zoomIOValidate(text.c_str());
+	if (error != fwwasm::zoomIOOk)
+	{
+		fprintf(stderr, "%s: %s\n", argv[1], kErrors[error]);
+		return 1;
+	}
+
+	fwwasm::ZoomIOScripts<1> scripts(countScript);
+	int handle = scripts.compile(text.c_str());
+	int params[fwwasm::ZOOMIO_PARAMS_MAX] = {};
+	size_t count = 0;
+	for (int i = 2; i < argc && count < fwwasm::ZOOMIO_PARAMS_MAX; i++)
+		params[count++] = static_cast<int>(strtol(argv[i], nullptr, 0));
+	if (scripts.run(handle, params, count) < 0)
+	{
+		fprintf(stderr, "%s: rendered script longer than %d bytes\n", argv[1], FWWASM_ZOOMIO_SCRIPT_MAX - 1);
+		return 1;
+	}
+	printf("%s\n", scripts.rendered(handle));
+
+	double rendered = timeRuns(scripts, handle, params, count, true);
+	double cached = timeRuns(scripts, handle, params, count, false);
+	fprintf(stderr, "%d parameters, %.1f ns per rendered run, %.1f ns per cached run\n", scripts.parameterCount(handle), rendered, cached);
+	return 0;
+}